@@ -0,0 +1,279 @@
+#ifndef CONCURRENT_SLAB_H
+#define CONCURRENT_SLAB_H
+
+#include "slab.h"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+/// Slab container for sharing between threads without locks.
+///
+/// Slots are stored in segments, each next segment is twice bigger than previous one,
+/// the segment directory has fixed size, so neither slots nor directory are ever relocated.
+/// Vacant slots are linked to the lock-free stack with the tagged head (ABA-safe).
+/// Keys are generational: low 32 bits are the slot index and high 32 bits are the generation of the slot,
+/// so stale keys of removed objects are rejected by contains(), remove() and take().
+///
+/// insert(), emplace(), remove(), take() and contains() are lock-free, get() is wait-free.
+/// As with pointers, the caller must guarantee that the object isn't removed
+/// while it's used by reference returned by get().
+template <class T>
+class ConcurrentSlab {
+public:
+    using key_type = uint64_t;
+
+private:
+    /// Number of slots in the first segment.
+    static constexpr size_t first_segment_size = 64;
+    static constexpr size_t first_segment_shift = slab_detail::log2_pow2(first_segment_size);
+    /// Number of segments enough for 32 bit slot indices.
+    static constexpr size_t segments_num = 32 - first_segment_shift + 1;
+    /// Index of the list end.
+    static constexpr uint32_t no_vacant = UINT32_MAX;
+
+    /// Slot of the element.
+    /// Generation is odd when slot is occupied and even when vacant.
+    struct Slot {
+        std::atomic<uint32_t> generation { 0 };
+        std::atomic<uint32_t> next_vacant { no_vacant };
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        inline T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    /// Directory of segments, segment k stores first_segment_size << k slots.
+    std::atomic<Slot*> segments[segments_num] = {};
+    /// Number of slots ever appended.
+    std::atomic<size_t> slots_count { 0 };
+    /// Number of stored objects.
+    std::atomic<size_t> objects_count { 0 };
+    /// Head of the stack of vacant slots: high 32 bits is the tag incremented on every change,
+    /// low 32 bits is the slot index.
+    std::atomic<uint64_t> vacant_head { no_vacant };
+
+    /// Returns the segment number of the slot index.
+    static inline size_t segment_of(size_t index) {
+        return 63 - slab_detail::clz64((index >> first_segment_shift) + 1);
+    }
+
+    /// Returns the first slot index of the segment.
+    static inline size_t segment_begin(size_t segment) {
+        return first_segment_size * ((size_t(1) << segment) - 1);
+    }
+
+    /// Returns the slot by the index, segment of the slot must be allocated.
+    inline Slot& slot_at(size_t index) const {
+        size_t segment = segment_of(index);
+        return segments[segment].load(std::memory_order_acquire)[index - segment_begin(segment)];
+    }
+
+    /// Returns the slot by the index or nullptr if the segment of the slot is not allocated yet.
+    inline Slot* find_slot(size_t index) const {
+        if (index >= slots_count.load(std::memory_order_acquire))
+            return nullptr;
+
+        size_t segment = segment_of(index);
+        Slot *slots = segments[segment].load(std::memory_order_acquire);
+        return slots ? &slots[index - segment_begin(segment)] : nullptr;
+    }
+
+    /// Returns the slot by the index, allocates the segment if it doesn't exist.
+    Slot& slot_at_or_allocate(size_t index) {
+        size_t segment = segment_of(index);
+        Slot *slots = segments[segment].load(std::memory_order_acquire);
+        if (!slots) {
+            Slot *allocated = new Slot[first_segment_size << segment];
+            if (segments[segment].compare_exchange_strong(slots, allocated, std::memory_order_acq_rel))
+                slots = allocated;
+            else
+                delete[] allocated;
+        }
+        return slots[index - segment_begin(segment)];
+    }
+
+    static inline key_type make_key(size_t index, uint32_t generation) {
+        return key_type(generation) << 32 | index;
+    }
+
+    /// Pops the slot from the stack of vacant slots, returns no_vacant if the stack is empty.
+    uint32_t pop_vacant() {
+        uint64_t head = vacant_head.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t index = uint32_t(head);
+            if (index == no_vacant)
+                return no_vacant;
+
+            // the slot may be already popped by other thread, then tag of the head is changed and CAS fails
+            uint32_t next = slot_at(index).next_vacant.load(std::memory_order_relaxed);
+            uint64_t new_head = ((head >> 32) + 1) << 32 | next;
+            if (vacant_head.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire))
+                return index;
+        }
+    }
+
+    /// Pushes the slot to the stack of vacant slots.
+    void push_vacant(uint32_t index) {
+        Slot &slot = slot_at(index);
+        uint64_t head = vacant_head.load(std::memory_order_relaxed);
+        for (;;) {
+            slot.next_vacant.store(uint32_t(head), std::memory_order_relaxed);
+            uint64_t new_head = ((head >> 32) + 1) << 32 | index;
+            if (vacant_head.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    /// Makes the occupied slot by the key vacant, returns nullptr if the key is stale or doesn't exist.
+    /// Only one of the threads removing the same key gets the slot.
+    Slot* claim(key_type key) {
+        uint32_t generation = uint32_t(key >> 32);
+        Slot *slot = find_slot(uint32_t(key));
+        if (!slot || !(generation & 1))
+            return nullptr;
+
+        if (!slot->generation.compare_exchange_strong(generation, generation + 1, std::memory_order_acq_rel))
+            return nullptr;
+        return slot;
+    }
+
+    /// Appends the new slot and returns its index.
+    /// The segment of the slot is allocated before the index is published by incrementing slots_count,
+    /// so if allocating throws nothing is changed and all slots below slots_count have segments.
+    size_t append_slot() {
+        size_t index = slots_count.load(std::memory_order_relaxed);
+        for (;;) {
+            if (index >= no_vacant)
+                throw std::length_error("ConcurrentSlab keys overflow");
+
+            slot_at_or_allocate(index);
+            if (slots_count.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+                return index;
+        }
+    }
+
+    template <class... Args>
+    key_type emplace_slot(Args&&... args) {
+        size_t index = pop_vacant();
+        if (index == no_vacant)
+            index = append_slot();
+
+        Slot &slot = slot_at(index);
+        try {
+            ::new (static_cast<void*>(slot.storage)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            push_vacant(uint32_t(index));
+            throw;
+        }
+
+        uint32_t generation = slot.generation.load(std::memory_order_relaxed) + 1;
+        slot.generation.store(generation, std::memory_order_release);
+        objects_count.fetch_add(1, std::memory_order_relaxed);
+        return make_key(index, generation);
+    }
+
+public:
+    ConcurrentSlab() = default;
+    ConcurrentSlab(const ConcurrentSlab &) = delete;
+    ConcurrentSlab& operator=(const ConcurrentSlab &) = delete;
+
+    /// Must not be called concurrently with other methods.
+    ~ConcurrentSlab() {
+        size_t count = slots_count.load();
+        for (size_t index = 0; index < count; ++index) {
+            Slot &slot = slot_at(index);
+            if (slot.generation.load(std::memory_order_relaxed) & 1)
+                slot.value()->~T();
+        }
+        for (auto &segment : segments)
+            delete[] segment.load();
+    }
+
+    /// Inserts a object and return the key of it in the slab.
+    /// Lock-free. Throws std::length_error if 32 bit slot indices are exhausted.
+    inline key_type insert(T &&obj) {
+        return emplace_slot(std::move(obj));
+    }
+
+    /// Inserts a object and return the key of it in the slab.
+    /// Lock-free. Throws std::length_error if 32 bit slot indices are exhausted.
+    inline key_type insert(const T &obj) {
+        return emplace_slot(obj);
+    }
+
+    /// Constructs a object in place from the arguments and return the key of it in the slab.
+    /// Lock-free. Throws std::length_error if 32 bit slot indices are exhausted.
+    template <class... Args>
+    inline key_type emplace(Args&&... args) {
+        return emplace_slot(std::forward<Args>(args)...);
+    }
+
+    /// Returns true if the object by the key exist or false if it doesn't.
+    /// Lock-free.
+    inline bool contains(key_type key) const {
+        uint32_t generation = uint32_t(key >> 32);
+        Slot *slot = find_slot(uint32_t(key));
+        return slot && (generation & 1) && slot->generation.load(std::memory_order_acquire) == generation;
+    }
+
+    /// Returns a reference to the object in the slab by the key.
+    /// Does not check whether the slab contains a value.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Wait-free.
+    inline T& get(key_type key) {
+        return *slot_at(uint32_t(key)).value();
+    }
+
+    /// Returns a const reference to the object in the slab by the key.
+    /// Does not check whether the slab contains a value.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Wait-free.
+    inline const T& get(key_type key) const {
+        return *slot_at(uint32_t(key)).value();
+    }
+
+    /// Removes object from the slab by the key.
+    /// Returns false if obect by key not exist or the key is stale.
+    /// Lock-free.
+    bool remove(key_type key) {
+        Slot *slot = claim(key);
+        if (!slot)
+            return false;
+
+        slot->value()->~T();
+        objects_count.fetch_sub(1, std::memory_order_relaxed);
+        push_vacant(uint32_t(key));
+        return true;
+    }
+
+    /// Move object from the slab by the key.
+    /// Returns moved stored object or std::nullopt if obect by key not exist or the key is stale.
+    /// Lock-free.
+    std::optional<T> take(key_type key) {
+        Slot *slot = claim(key);
+        if (!slot)
+            return std::nullopt;
+
+        std::optional<T> res(std::move(*slot->value()));
+        slot->value()->~T();
+        objects_count.fetch_sub(1, std::memory_order_relaxed);
+        push_vacant(uint32_t(key));
+        return res;
+    }
+
+    /// Returns the number of stored objects.
+    /// With concurrent modifications the value is approximate.
+    inline size_t size() const {
+        return objects_count.load(std::memory_order_relaxed);
+    }
+
+    /// Returns true if there are no objects stored in the slab.
+    inline bool empty() const {
+        return size() == 0;
+    }
+};
+
+#endif
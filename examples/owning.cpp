@@ -37,6 +37,16 @@ int main() {
     //    optional<TestType> t = slab.take_and_remove(key);
     cout << endl;
 
+    // To avoid temporary object and moving,
+    // construct the object directly in the slot of the slab.
+    cout << "Emplace to slab:" << endl;
+    key = slab.emplace();
+    cout << endl;
+
+    cout << "Take from slab:" << endl;
+    optional<TestType> taken = slab.take(key);
+    cout << endl;
+
     cout << "Finish!" << endl;
     return 0;
 }
@@ -1,4 +1,5 @@
 #include "../slab.h"
+#include "../multi_slab.h"
 
 #include <variant>
 #include <iostream>
@@ -30,5 +31,21 @@ int main()
         } , animal);
     }
 
+    // Every slot of the variant slab has the size of the largest type
+    // and every element is dispatched by std::visit.
+    // MultiSlab keeps one pool per type, so slots are not padded
+    // and visit_all dispatches once per pool, loops over one type stay homogeneous.
+
+    MultiSlab<Cat, Dog> zoo;
+    auto tom = zoo.insert(Cat());
+    zoo.insert(Dog());
+    zoo.insert(Cat());
+
+    zoo.visit_all([] (auto &animal) {
+        cout << animal.is() << endl;
+    });
+
+    cout << zoo.get(tom).is() << endl;
+
     return 0;
 }
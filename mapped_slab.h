@@ -0,0 +1,403 @@
+#ifndef MAPPED_SLAB_H
+#define MAPPED_SLAB_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Slab container stored in the memory-mapped file, for trivially copyable objects.
+///
+/// Slots, the occupancy bitmap and the list of vacant slots live in the file,
+/// so reopening the file after restart restores the exact key to object mapping
+/// without inserting objects again, only the file is mapped.
+/// File layout: header, slots, occupancy bitmap. Growing doubles the capacity,
+/// extends the file and remaps it, only the bitmap is moved.
+/// Growing records the new capacity as pending before extending the file and updates the capacity last,
+/// so a file extended by growing interrupted by a crash is truncated back to the old capacity on opening.
+/// Any other file which length doesn't match the capacity in the header is rejected.
+///
+/// The header records the size and the alignment of the object and the type tag given on creating,
+/// opening with other ones is rejected. The file doesn't know the type itself, so objects of different types
+/// with the same size and alignment are told apart only by the tag (for example a hash of the type name and its schema version).
+///
+/// Changes reach the file through the page cache, sync() is the durability point.
+/// References returned by get() and iterators are invalidated on growth, same as for the contiguous Slab.
+/// Iteration visits occupied slots in order of keys, so after reopening objects can be enumerated
+/// with their keys without knowing the keys in advance.
+/// POSIX only.
+template <class T>
+class MappedSlab {
+    static_assert(std::is_trivially_copyable_v<T>, "MappedSlab stores only trivially copyable objects.");
+
+public:
+    using key_type = uint64_t;
+
+private:
+    static constexpr uint64_t magic = 0x3150414d42414c53; // "SLABMAP1"
+    static constexpr uint32_t version = 2;
+    /// Index of the list end.
+    static constexpr key_type no_vacant = UINT64_MAX;
+
+    struct alignas(64) Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t value_size;
+        uint32_t value_align;
+        /// Tag of the object type given by the user.
+        uint64_t type_tag;
+        /// Number of slots the file has place for, multiple of 64.
+        uint64_t capacity;
+        /// Capacity being grown to, equal to capacity when growing is not in progress.
+        uint64_t pending_capacity;
+        /// Number of used slots, occupied or vacant.
+        uint64_t count;
+        /// Head of the list of vacant slots.
+        key_type vacant_head;
+        uint64_t vacant_count;
+    };
+
+    /// Occupied slot stores the object, vacant slot stores the index of next vacant slot.
+    union Slot {
+        T value;
+        key_type next_vacant;
+    };
+
+    static constexpr size_t slots_offset = (sizeof(Header) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+
+    int fd = -1;
+    void *region = nullptr;
+    size_t region_size = 0;
+
+    /// Returns the size of the file for the capacity.
+    static inline size_t file_size(size_t capacity) {
+        return bitmap_offset(capacity) + capacity / 8;
+    }
+
+    static inline size_t bitmap_offset(size_t capacity) {
+        return (slots_offset + capacity * sizeof(Slot) + 7) & ~size_t(7);
+    }
+
+    inline Header& header() const { return *static_cast<Header*>(region); }
+
+    inline Slot* slots() const {
+        return reinterpret_cast<Slot*>(static_cast<char*>(region) + slots_offset);
+    }
+
+    inline uint64_t* bitmap() const {
+        return reinterpret_cast<uint64_t*>(static_cast<char*>(region) + bitmap_offset(header().capacity));
+    }
+
+    inline bool occupied(size_t index) const { return (bitmap()[index >> 6] >> (index & 63)) & 1; }
+    inline void set_occupied(size_t index) { bitmap()[index >> 6] |= uint64_t(1) << (index & 63); }
+    inline void reset_occupied(size_t index) { bitmap()[index >> 6] &= ~(uint64_t(1) << (index & 63)); }
+
+    /// Returns the first occupied slot at or after index or count if there is no such slot.
+    /// Words without occupied slots are skipped at once.
+    size_t find_next(size_t index) const {
+        size_t count = size_t(header().count);
+        const uint64_t *words = bitmap();
+        while (index < count) {
+            uint64_t word = words[index >> 6] >> (index & 63);
+            if (word == 0)
+                index = (index | 63) + 1;
+            else
+                return std::min(index + size_t(__builtin_ctzll(word)), count);
+        }
+        return count;
+    }
+
+    [[noreturn]] static void throw_errno(const char *what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    /// Maps the whole file of the specified size.
+    void map(size_t size) {
+        void *mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED)
+            throw_errno("MappedSlab mmap");
+        region = mapped;
+        region_size = size;
+    }
+
+    void unmap() {
+        if (region)
+            ::munmap(region, region_size);
+        region = nullptr;
+        region_size = 0;
+    }
+
+    void close() {
+        unmap();
+        if (fd != -1)
+            ::close(fd);
+        fd = -1;
+    }
+
+    /// Initializes the empty file.
+    void create(size_t capacity, uint64_t type_tag) {
+        if (::ftruncate(fd, off_t(file_size(capacity))) != 0)
+            throw_errno("MappedSlab ftruncate");
+
+        map(file_size(capacity));
+        header() = Header { magic, version, uint32_t(sizeof(T)), uint32_t(alignof(T)), type_tag,
+                            capacity, capacity, 0, no_vacant, 0 };
+    }
+
+    /// Checks the header of the existing file, drops the tail of the file left by interrupted growing.
+    void open_existing(size_t size, uint64_t type_tag) {
+        if (size < sizeof(Header))
+            throw std::runtime_error("MappedSlab file is corrupted");
+
+        map(size);
+        Header &h = header();
+        if (h.magic != magic || h.version != version || h.value_size != sizeof(T) || h.value_align != alignof(T)
+            || h.type_tag != type_tag)
+            throw std::runtime_error("MappedSlab file has incompatible format");
+        if (h.capacity % 64 != 0 || h.count > h.capacity)
+            throw std::runtime_error("MappedSlab file is corrupted");
+
+        size_t expected = file_size(h.capacity);
+        if (size == expected) {
+            h.pending_capacity = h.capacity;
+            return;
+        }
+        // only growing interrupted after extending the file leaves it longer, with the new size recorded as pending
+        if (h.pending_capacity != h.capacity * 2 || size != file_size(h.pending_capacity))
+            throw std::runtime_error("MappedSlab file is corrupted");
+
+        h.pending_capacity = h.capacity;
+        unmap();
+        if (::ftruncate(fd, off_t(expected)) != 0)
+            throw_errno("MappedSlab ftruncate");
+        map(expected);
+    }
+
+    /// Doubles the capacity: extends the file, remaps it and moves the bitmap to the new end.
+    /// The old mapping is dropped only after the new one is made, so if mapping fails the slab stays usable
+    /// and the next growing extends the file again.
+    void grow() {
+        size_t old_capacity = header().capacity;
+        size_t new_capacity = old_capacity * 2;
+        size_t words = old_capacity / 64;
+
+        header().pending_capacity = new_capacity;
+        if (::ftruncate(fd, off_t(file_size(new_capacity))) != 0)
+            throw_errno("MappedSlab ftruncate");
+
+        void *old_region = region;
+        size_t old_size = region_size;
+        map(file_size(new_capacity));
+        ::munmap(old_region, old_size);
+        char *base = static_cast<char*>(region);
+        std::memmove(base + bitmap_offset(new_capacity), base + bitmap_offset(old_capacity), words * sizeof(uint64_t));
+        std::memset(base + bitmap_offset(new_capacity) + words * sizeof(uint64_t), 0, words * sizeof(uint64_t));
+        header().capacity = new_capacity;
+    }
+
+    /// Returns the index of the vacant or new slot for the object.
+    size_t acquire_slot() {
+        Header &h = header();
+        if (h.vacant_head != no_vacant) {
+            size_t index = h.vacant_head;
+            h.vacant_head = slots()[index].next_vacant;
+            --h.vacant_count;
+            return index;
+        }
+        if (h.count == h.capacity)
+            grow();
+        return header().count++;
+    }
+
+public:
+    /// Opens the slab stored in the file or creates the file if it doesn't exist.
+    /// New file gets place for start_capacity slots, rounded up to 64, and records the type tag.
+    /// Throws std::system_error if the file can't be opened or mapped
+    /// and std::runtime_error if the file is not a slab of objects with the same size, alignment and type tag
+    /// or its length doesn't match the header.
+    explicit MappedSlab(const std::string &path, size_t start_capacity = 64, uint64_t type_tag = 0) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd == -1)
+            throw_errno("MappedSlab open");
+
+        try {
+            struct stat st;
+            if (::fstat(fd, &st) != 0)
+                throw_errno("MappedSlab fstat");
+
+            if (st.st_size == 0)
+                create(std::max<size_t>((start_capacity + 63) & ~size_t(63), 64), type_tag);
+            else
+                open_existing(size_t(st.st_size), type_tag);
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    MappedSlab(const MappedSlab &) = delete;
+    MappedSlab& operator=(const MappedSlab &) = delete;
+
+    /// Unmaps the file without waiting for writing changes to the disk, see sync().
+    ~MappedSlab() {
+        close();
+    }
+
+    /// Inserts a object and return the key of it in the slab.
+    /// Сomplexity O(1), but if not enough capacity the file is extended and remapped.
+    inline key_type insert(const T &obj) {
+        return emplace(obj);
+    }
+
+    /// Constructs a object in place from the arguments and return the key of it in the slab.
+    /// Сomplexity O(1), but if not enough capacity the file is extended and remapped.
+    template <class... Args>
+    key_type emplace(Args&&... args) {
+        // arguments may refer to objects of the slab, which are moved by remapping on growth
+        T obj(std::forward<Args>(args)...);
+        size_t index = acquire_slot();
+        ::new (static_cast<void*>(&slots()[index].value)) T(obj);
+        set_occupied(index);
+        return index;
+    }
+
+    /// Returns true if the object by the key exist or false if it doesn't.
+    inline bool contains(key_type key) const {
+        return key < header().count && occupied(key);
+    }
+
+    /// Returns a pointer to the object in the slab by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    inline T* try_get(key_type key) {
+        return contains(key) ? &slots()[key].value : nullptr;
+    }
+
+    /// Returns a reference to the object in the slab by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1).
+    inline T& get(key_type key) {
+        return slots()[key].value;
+    }
+
+    /// Returns a const reference to the object in the slab by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1).
+    inline const T& get(key_type key) const {
+        return slots()[key].value;
+    }
+
+    /// Removes object from the slab by the key.
+    /// Returns false if obect by key not exist.
+    /// Сomplexity O(1).
+    bool remove(key_type key) {
+        if (!contains(key))
+            return false;
+
+        Header &h = header();
+        reset_occupied(key);
+        slots()[key].next_vacant = h.vacant_head;
+        h.vacant_head = key;
+        ++h.vacant_count;
+        return true;
+    }
+
+    /// Move object from the slab by the key.
+    /// Returns moved stored object or std::nullopt if obect by key not exist.
+    /// Сomplexity O(1).
+    std::optional<T> take(key_type key) {
+        if (!contains(key))
+            return std::nullopt;
+
+        std::optional<T> res(slots()[key].value);
+        remove(key);
+        return res;
+    }
+
+    /// Writes all changes to the file and waits for completion.
+    /// After returning the current state survives a crash of the process or of the system.
+    void sync() {
+        if (::msync(region, region_size, MS_SYNC) != 0)
+            throw_errno("MappedSlab msync");
+    }
+
+    /// Returns the number of stored objects.
+    /// Сomplexity O(1).
+    inline size_t size() const {
+        return size_t(header().count - header().vacant_count);
+    }
+
+    /// Returns true if there are no objects stored in the slab.
+    /// Сomplexity O(1).
+    inline bool empty() const {
+        return size() == 0;
+    }
+
+    /// Returns the number of objects the slab can store without extending the file.
+    inline size_t slots_capacity() const {
+        return size_t(header().capacity);
+    }
+
+    /// Forward iterator over objects in order of keys, vacant slots are skipped with the occupancy bitmap of the file.
+    template <bool Const>
+    class BasicIterator {
+        using Owner = std::conditional_t<Const, const MappedSlab, MappedSlab>;
+
+        Owner *slab;
+        /// Index of the slot.
+        size_t pos;
+
+        BasicIterator(Owner *slab, size_t pos) : slab(slab), pos(slab->find_next(pos)) {}
+
+        friend MappedSlab;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = T;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+
+        inline reference operator*() const { return slab->slots()[pos].value; }
+        inline pointer operator->() const { return &slab->slots()[pos].value; }
+
+        /// Returns the key of the object.
+        inline key_type key() const { return pos; }
+
+        inline BasicIterator& operator++() {
+            pos = slab->find_next(pos + 1);
+            return *this;
+        }
+
+        inline BasicIterator operator++(int) {
+            BasicIterator res = *this;
+            ++*this;
+            return res;
+        }
+
+        friend inline bool operator==(const BasicIterator &a, const BasicIterator &b) { return a.pos == b.pos; }
+        friend inline bool operator!=(const BasicIterator &a, const BasicIterator &b) { return a.pos != b.pos; }
+    };
+
+    using Iterator = BasicIterator<false>;
+    using ConstIterator = BasicIterator<true>;
+
+    inline Iterator begin() { return Iterator(this, 0); }
+    inline Iterator end() { return Iterator(this, size_t(header().count)); }
+    inline ConstIterator begin() const { return ConstIterator(this, 0); }
+    inline ConstIterator end() const { return ConstIterator(this, size_t(header().count)); }
+};
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef MULTI_SLAB_H
+#define MULTI_SLAB_H
+
+#include "slab.h"
+
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace slab_detail {
+
+/// Index of T in Ts.
+template <class T, class... Ts>
+struct TypeIndex;
+
+template <class T, class... Ts>
+struct TypeIndex<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+template <class T, class U, class... Ts>
+struct TypeIndex<T, U, Ts...> : std::integral_constant<size_t, 1 + TypeIndex<T, Ts...>::value> {};
+
+/// True if all types are different.
+template <class... Ts>
+struct DistinctTypes : std::true_type {};
+
+template <class T, class... Ts>
+struct DistinctTypes<T, Ts...>
+    : std::bool_constant<!(std::is_same_v<T, Ts> || ...) && DistinctTypes<Ts...>::value> {};
+
+} // namespace slab_detail
+
+/// Slab container of objects of several types, each type has its own dense pool (Slab<T>).
+///
+/// Unlike Slab<std::variant<Ts...>>, slots have the size of their type instead of the largest one,
+/// and objects of one type are iterated without dispatching on every element:
+/// pool<T>() gives the homogeneous Slab<T> with all its methods, visit_all() walks pools type by type.
+///
+/// Keys are typed: Key<T> holds the key in the pool of T, the type is known at compile time.
+/// Key<T> converts to AnyKey with the type tag (index of T in Ts) for storing keys of different types together.
+template <class... Ts>
+class MultiSlab {
+    static_assert(sizeof...(Ts) > 0, "MultiSlab needs at least one type.");
+    static_assert(slab_detail::DistinctTypes<Ts...>::value, "MultiSlab types must be different.");
+
+public:
+    using key_type = size_t;
+
+    /// Index of the type in Ts, the type tag of keys.
+    template <class T>
+    static constexpr uint32_t tag_of = uint32_t(slab_detail::TypeIndex<T, Ts...>::value);
+
+    /// Key of the object of any type: the type tag and the key in the pool of the type.
+    struct AnyKey {
+        uint32_t tag;
+        key_type key;
+
+        friend inline bool operator==(const AnyKey &a, const AnyKey &b) { return a.tag == b.tag && a.key == b.key; }
+        friend inline bool operator!=(const AnyKey &a, const AnyKey &b) { return !(a == b); }
+    };
+
+    /// Key of the object of type T in the pool of T.
+    template <class T>
+    struct Key {
+        key_type key;
+
+        static constexpr uint32_t tag = tag_of<T>;
+
+        inline operator AnyKey() const { return AnyKey { tag, key }; }
+
+        friend inline bool operator==(const Key &a, const Key &b) { return a.key == b.key; }
+        friend inline bool operator!=(const Key &a, const Key &b) { return a.key != b.key; }
+    };
+
+private:
+    std::tuple<Slab<Ts>...> pools;
+
+    /// Calls f(pool) for the pool with the tag, returns false if there is no such type.
+    /// Tuple is the tuple of pools, const or not.
+    template <class Tuple, class F, size_t... I>
+    static inline bool with_pool(Tuple &tuple, uint32_t tag, F &&f, std::index_sequence<I...>) {
+        return ((tag == I ? (f(std::get<I>(tuple)), true) : false) || ...);
+    }
+
+    template <class F>
+    inline bool with_pool(uint32_t tag, F &&f) {
+        return with_pool(pools, tag, f, std::index_sequence_for<Ts...>());
+    }
+
+    template <class F>
+    inline bool with_pool(uint32_t tag, F &&f) const {
+        return with_pool(pools, tag, f, std::index_sequence_for<Ts...>());
+    }
+
+    /// Calls f(object) for the object by the key, Self is MultiSlab or const MultiSlab.
+    template <class Self, class F>
+    static bool visit_key(Self &self, AnyKey key, F &f) {
+        bool found = false;
+        self.with_pool(key.tag, [&](auto &pool) {
+            if (auto *obj = pool.try_get(key.key)) {
+                f(*obj);
+                found = true;
+            }
+        });
+        return found;
+    }
+
+public:
+    /// Returns the pool of objects of type T.
+    /// The pool is a usual Slab<T>: its keys are keys of Key<T>, iteration and search over it are homogeneous.
+    template <class T>
+    inline Slab<T>& pool() {
+        return std::get<tag_of<T>>(pools);
+    }
+
+    /// Returns the const pool of objects of type T.
+    template <class T>
+    inline const Slab<T>& pool() const {
+        return std::get<tag_of<T>>(pools);
+    }
+
+    /// Inserts a object to the pool of its type and return the typed key of it.
+    /// The object is copied or moved depending on the value category.
+    /// Сomplexity O(1), but the pool may grow same as Slab.
+    template <class T>
+    inline Key<std::decay_t<T>> insert(T &&obj) {
+        using U = std::decay_t<T>;
+        return Key<U> { pool<U>().emplace(std::forward<T>(obj)) };
+    }
+
+    /// Constructs a object of type T in place from the arguments and return the typed key of it.
+    /// Сomplexity O(1), but the pool may grow same as Slab.
+    template <class T, class... Args>
+    inline Key<T> emplace(Args&&... args) {
+        return Key<T> { pool<T>().emplace(std::forward<Args>(args)...) };
+    }
+
+    /// Returns true if the object by the key exist or false if it doesn't.
+    template <class T>
+    inline bool contains(Key<T> key) const {
+        return pool<T>().contains(key.key);
+    }
+
+    /// Returns true if the object by the key exist or false if it doesn't.
+    inline bool contains(AnyKey key) const {
+        return visit(key, [](const auto &) {});
+    }
+
+    /// Returns a pointer to the object by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    template <class T>
+    inline T* try_get(Key<T> key) {
+        return pool<T>().try_get(key.key);
+    }
+
+    /// Returns a reference to the object by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1).
+    template <class T>
+    inline T& get(Key<T> key) {
+        return pool<T>().get(key.key);
+    }
+
+    /// Returns a const reference to the object by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1).
+    template <class T>
+    inline const T& get(Key<T> key) const {
+        return pool<T>().get(key.key);
+    }
+
+    /// Removes object by the key.
+    /// Returns false if obect by key not exist.
+    /// Сomplexity O(1).
+    template <class T>
+    inline bool remove(Key<T> key) {
+        return pool<T>().remove(key.key);
+    }
+
+    /// Removes object by the key of any type.
+    /// Returns false if obect by key not exist.
+    /// Сomplexity O(1).
+    inline bool remove(AnyKey key) {
+        bool removed = false;
+        with_pool(key.tag, [&](auto &pool) { removed = pool.remove(key.key); });
+        return removed;
+    }
+
+    /// Move object by the key.
+    /// Returns moved stored object or std::nullopt if obect by key not exist.
+    /// Сomplexity O(1).
+    template <class T>
+    inline std::optional<T> take(Key<T> key) {
+        return pool<T>().take(key.key);
+    }
+
+    /// Calls f(object) for the object by the key of any type, f must accept every type of Ts.
+    /// Returns false if obect by key not exist.
+    /// Сomplexity O(1), one dispatch by the type tag.
+    template <class F>
+    inline bool visit(AnyKey key, F &&f) {
+        return visit_key(*this, key, f);
+    }
+
+    /// Calls f(const object) for the object by the key of any type.
+    /// Returns false if obect by key not exist.
+    template <class F>
+    inline bool visit(AnyKey key, F &&f) const {
+        return visit_key(*this, key, f);
+    }
+
+    /// Calls f(object) for all objects of type T in order of keys.
+    template <class T, class F>
+    inline void for_each(F &&f) {
+        for (T &obj : pool<T>())
+            f(obj);
+    }
+
+    /// Calls f(object) for all objects, pool by pool in order of Ts,
+    /// so the type is dispatched once per pool instead of once per object and every loop is homogeneous.
+    /// f must accept every type of Ts, for example a generic lambda.
+    template <class F>
+    void visit_all(F &&f) {
+        std::apply([&](auto &... pool) { (visit_pool(pool, f), ...); }, pools);
+    }
+
+    /// Returns the number of stored objects of all types.
+    /// Сomplexity O(number of types).
+    inline size_t size() const {
+        return std::apply([](const auto &... pool) { return (pool.size() + ...); }, pools);
+    }
+
+    /// Returns the number of stored objects of type T.
+    /// Сomplexity O(1).
+    template <class T>
+    inline size_t size() const {
+        return pool<T>().size();
+    }
+
+    /// Returns true if there are no objects of any type.
+    inline bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    template <class Pool, class F>
+    static inline void visit_pool(Pool &pool, F &f) {
+        for (auto &obj : pool)
+            f(obj);
+    }
+};
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef SHARDED_SLAB_H
+#define SHARDED_SLAB_H
+
+#include "slab.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// Default configuration of the shard of the sharded slab.
+/// Paged storage keeps objects in place while other threads use them.
+/// Keys of the shard must be no wider than 32 bits.
+/// Keys are generational (8 bits of generation, up to 2^24 slots per shard), since removes by other threads
+/// are checked only by the owner when it collects them: a stale or repeated remote remove is dropped
+/// instead of removing the object that has reused the slot.
+struct ShardTraits : SlabTraits {
+    using key_type = uint32_t;
+    static constexpr size_t page_size = 1024;
+    static constexpr unsigned generation_bits = 8;
+};
+
+/// Slab container divided to shards, each shard is owned by one thread.
+///
+/// The owner thread inserts to its shard without any synchronization.
+/// Keys encode the shard: high 32 bits are the shard number and low 32 bits are the key in the shard.
+/// Removing by the owner is direct. Removing by other thread appends the key to the outgoing batch
+/// of that thread, full batches are pushed to the lock-free remote free stack of the owner shard,
+/// and the owner drains it before its next insert.
+/// So threads touch shared cache lines only once per batch instead of on every insert and remove.
+///
+/// Every thread works through its own ShardedSlab::Local handle, see local().
+template <class T, class Traits = ShardTraits>
+class ShardedSlab {
+    using ShardSlab = Slab<T, Traits>;
+    static_assert(sizeof(typename ShardSlab::key_type) <= sizeof(uint32_t), "Shard keys must be no wider than 32 bits.");
+
+public:
+    using key_type = uint64_t;
+
+    /// Number of keys removed by other thread that are passed to the owner shard at once.
+    static constexpr size_t batch_size = 64;
+
+private:
+    /// Keys removed by other thread.
+    struct Batch {
+        Batch *next = nullptr;
+        size_t count = 0;
+        typename ShardSlab::key_type keys[batch_size];
+    };
+
+    struct alignas(64) Shard {
+        ShardSlab slab;
+        /// Stack of batches of keys removed by other threads.
+        std::atomic<Batch*> remote_frees { nullptr };
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    static inline size_t shard_of(key_type key) {
+        return size_t(key >> 32);
+    }
+
+    static inline typename ShardSlab::key_type shard_key(key_type key) {
+        return typename ShardSlab::key_type(key);
+    }
+
+    static inline key_type make_key(size_t shard, typename ShardSlab::key_type key) {
+        return key_type(shard) << 32 | key;
+    }
+
+    /// Pushes the batch to the remote free stack of the shard.
+    static void push_batch(Shard &shard, Batch *batch) {
+        batch->next = shard.remote_frees.load(std::memory_order_relaxed);
+        while (!shard.remote_frees.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /// Removes objects by keys of all batches of the stack and frees the batches.
+    /// Keys of not existing objects are dropped, see Slab::remove_keys().
+    static size_t free_batches(ShardSlab &slab, Batch *batch) {
+        size_t removed = 0;
+        while (batch) {
+            removed += slab.remove_keys(batch->keys, batch->keys + batch->count);
+            delete std::exchange(batch, batch->next);
+        }
+        return removed;
+    }
+
+public:
+    /// Handle of the shard for the thread owning it.
+    /// Must be used only by one thread at a time.
+    class Local {
+        ShardedSlab &owner;
+        size_t id;
+        Shard &shard;
+        /// Not full batches of keys removed from other shards, by the shard number.
+        std::vector<Batch*> outgoing;
+
+        Local(ShardedSlab &owner, size_t id)
+            : owner(owner)
+            , id(id)
+            , shard(*owner.shards[id])
+            , outgoing(owner.shards.size(), nullptr) {
+        }
+
+        friend ShardedSlab;
+
+    public:
+        Local(const Local &) = delete;
+        Local& operator=(const Local &) = delete;
+
+        Local(Local &&other)
+            : owner(other.owner)
+            , id(other.id)
+            , shard(other.shard)
+            , outgoing(std::move(other.outgoing)) {
+        }
+
+        /// Flushes not full outgoing batches.
+        ~Local() {
+            flush();
+        }
+
+        /// Returns the number of the shard.
+        inline size_t shard_id() const {
+            return id;
+        }
+
+        /// Inserts a object to the shard and return the key of it.
+        /// Before inserting removes objects freed by other threads, so their slots are reused.
+        inline key_type insert(T &&obj) {
+            collect_if_needed();
+            return make_key(id, shard.slab.insert(std::move(obj)));
+        }
+
+        /// Inserts a object to the shard and return the key of it.
+        /// Before inserting removes objects freed by other threads, so their slots are reused.
+        inline key_type insert(T &obj) {
+            collect_if_needed();
+            return make_key(id, shard.slab.insert(obj));
+        }
+
+        /// Constructs a object in place in the shard and return the key of it.
+        /// Before inserting removes objects freed by other threads, so their slots are reused.
+        template <class... Args>
+        inline key_type emplace(Args&&... args) {
+            collect_if_needed();
+            return make_key(id, shard.slab.emplace(std::forward<Args>(args)...));
+        }
+
+        /// Removes object by the key.
+        /// Object of this shard is removed immediately, returns false if it doesn't exist.
+        /// Key of other shard is added to the outgoing batch and true is returned, meaning only that the key is queued:
+        /// the owner of that shard removes the object when it collects the batch and drops keys of not existing objects,
+        /// with generational shard keys (default) also stale keys of objects whose slots were reused.
+        bool remove(key_type key) {
+            size_t target = shard_of(key);
+            if (target == id)
+                return shard.slab.remove(shard_key(key));
+
+            Batch *&batch = outgoing[target];
+            if (!batch)
+                batch = new Batch;
+
+            batch->keys[batch->count++] = shard_key(key);
+            if (batch->count == batch_size) {
+                push_batch(*owner.shards[target], batch);
+                batch = nullptr;
+            }
+            return true;
+        }
+
+        /// Move object of this shard by the key.
+        /// Returns moved stored object or std::nullopt if obect by key not exist or belongs to other shard.
+        inline std::optional<T> take(key_type key) {
+            if (shard_of(key) != id)
+                return std::nullopt;
+            return shard.slab.take(shard_key(key));
+        }
+
+        /// Returns true if the object of this shard by the key exist.
+        inline bool contains(key_type key) const {
+            return shard_of(key) == id && shard.slab.contains(shard_key(key));
+        }
+
+        /// Returns a reference to the object of this shard by the key.
+        /// If the object by key doesn't exist then undefined behavior.
+        inline T& get(key_type key) {
+            return shard.slab.get(shard_key(key));
+        }
+
+        /// Passes not full outgoing batches to their shards.
+        void flush() {
+            for (size_t target = 0; target < outgoing.size(); ++target) {
+                if (outgoing[target]) {
+                    push_batch(*owner.shards[target], outgoing[target]);
+                    outgoing[target] = nullptr;
+                }
+            }
+        }
+
+        /// Removes objects of this shard freed by other threads.
+        /// Returns the number of removed objects.
+        inline size_t collect() {
+            return free_batches(shard.slab, shard.remote_frees.exchange(nullptr, std::memory_order_acquire));
+        }
+
+        /// Returns the number of objects stored in this shard.
+        inline size_t size() const {
+            return shard.slab.size();
+        }
+
+    private:
+        inline void collect_if_needed() {
+            if (shard.remote_frees.load(std::memory_order_relaxed))
+                collect();
+        }
+    };
+
+    /// Constructs a new slab with the specified number of shards, usually the number of threads.
+    explicit ShardedSlab(size_t shards_num) {
+        shards.reserve(shards_num);
+        for (size_t i = 0; i < shards_num; ++i)
+            shards.push_back(std::make_unique<Shard>());
+    }
+
+    ShardedSlab(const ShardedSlab &) = delete;
+    ShardedSlab& operator=(const ShardedSlab &) = delete;
+
+    /// Must not be called concurrently with other methods and after destroying of all Local handles.
+    ~ShardedSlab() {
+        for (auto &shard : shards)
+            free_batches(shard->slab, shard->remote_frees.exchange(nullptr));
+    }
+
+    /// Returns the handle of the shard by the number.
+    /// Each shard must be used by only one thread at a time.
+    inline Local local(size_t shard_id) {
+        if (shard_id >= shards.size())
+            throw std::out_of_range("ShardedSlab shard doesn't exist");
+        return Local(*this, shard_id);
+    }
+
+    /// Returns the number of shards.
+    inline size_t shards_num() const {
+        return shards.size();
+    }
+
+    /// Returns a reference to the object in the slab by the key.
+    /// Does not check whether the slab contains a value.
+    /// When called not by the owner thread of the shard, the owner must not insert concurrently,
+    /// since the page directory of the shard may be relocated on growth.
+    inline T& get(key_type key) {
+        return shards[shard_of(key)]->slab.get(shard_key(key));
+    }
+
+    /// Returns the number of stored objects, including objects removed by other threads but not collected yet.
+    /// Must not be called concurrently with modifications.
+    size_t size() const {
+        size_t res = 0;
+        for (auto &shard : shards)
+            res += shard->slab.size();
+        return res;
+    }
+};
+
+#endif
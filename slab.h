@@ -1,78 +1,2259 @@
 #ifndef SLAB_H
 #define SLAB_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <iterator>
 #include <optional>
 #include <initializer_list>
+#include <limits>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <ostream>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/// AVX2 kernels are compiled with the target attribute and selected at runtime.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SLAB_AVX2 1
+#define SLAB_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define SLAB_AVX2 0
+#endif
+
+/// Order in which vacant slots of removed objects are reused by inserts.
+enum class SlabReuse {
+    /// The most recently vacated slot first, its memory is likely still in cache.
+    lifo,
+    /// The least recently vacated slot first, so keys are reused as late as possible.
+    fifo,
+    /// The lowest vacant slot first, so objects stay packed at the front of the storage
+    /// and iteration skips less vacant slots after churn.
+    lowest
+};
+
+/// Default configuration of the slab.
+/// For custom configuration inherit from it and override needed members.
+struct SlabTraits {
+    /// Unsigned integer type of keys.
+    /// Also used for links between vacant slots and for slot generations,
+    /// so narrow type makes them and structures that store keys smaller.
+    using key_type = size_t;
+
+    /// Number of slots in one storage page.
+    /// Zero means that all slots are stored in one contiguous pool
+    /// which is relocated on growth with same logic as std::vector.
+    /// Non zero value must be a power of two, then slots are stored in fixed size pages,
+    /// growing allocates only a new page and stored objects are never relocated.
+    static constexpr size_t page_size = 0;
+
+    /// Number of high key bits used for the generation of the slot.
+    /// Zero means that key is the slot index and after removing it is reused as is for new elements.
+    /// Non zero value makes every insert and remove change the generation of the slot,
+    /// so stale keys of removed objects are rejected by contains(), try_get(), remove() and take().
+    static constexpr unsigned generation_bits = 0;
+
+    /// Collects runtime statistics, see Slab::stats() and Slab::set_growth_hook().
+    /// When disabled the statistics are compiled out and take no space.
+    static constexpr bool stats = false;
+
+    /// Policy of reusing vacant slots, see SlabReuse.
+    /// lifo and fifo take the slot from the list of vacant slots in O(1).
+    /// lowest finds the next lowest vacant slot in the occupancy bitmap, it scans 64 slots per step,
+    /// so inserting is O(1) when vacant slots are dense and O(n / 64) in the worst case.
+    static constexpr SlabReuse reuse = SlabReuse::lifo;
+};
+
+/// Configuration of the slab with paged storage.
+template <size_t PageSize>
+struct PagedSlabTraits : SlabTraits {
+    static constexpr size_t page_size = PageSize;
+};
+
+/// Configuration of the slab with generational keys.
+template <unsigned GenerationBits = 32>
+struct GenerationalSlabTraits : SlabTraits {
+    static constexpr unsigned generation_bits = GenerationBits;
+};
+
+/// Runtime statistics of the slab, collected when enabled by Traits::stats.
+struct SlabStats {
+    /// Number of inserted objects, reused_slots + appended_slots.
+    size_t inserts = 0;
+    /// Number of objects inserted to vacant slots of removed objects.
+    size_t reused_slots = 0;
+    /// Number of objects inserted to new slots appended to the storage.
+    size_t appended_slots = 0;
+    /// Number of removed objects.
+    size_t removes = 0;
+    /// Maximum number of stored objects.
+    size_t high_water_mark = 0;
+    /// Number of reallocations of contiguous storage, paged storage grows by pages without reallocations.
+    size_t reallocations = 0;
+    /// Number of bytes of slots moved by reallocations.
+    size_t bytes_moved = 0;
+    /// Longest run of vacant slots at the time of the snapshot, iterators skip such run at once.
+    size_t longest_vacant_run = 0;
+    /// Vacant slots divided by all slots at the time of the snapshot, zero if there are no slots.
+    double fragmentation = 0;
+};
+
+/// Growth of the slab storage reported to the growth hook.
+struct SlabGrowth {
+    /// Capacity in slots before and after growing.
+    size_t old_capacity;
+    size_t new_capacity;
+    /// Number of bytes of slots moved to the new memory, zero for paged storage.
+    size_t bytes_moved;
+    /// Time of growing including moving of slots.
+    std::chrono::nanoseconds duration;
+};
+
+namespace slab_detail {
+
+/// Storage of statistics, the base class of the slab so it takes no space when statistics are disabled.
+template <bool Enabled>
+struct StatsStorage {};
+
+template <>
+struct StatsStorage<true> {
+    SlabStats counters;
+    std::function<void(const SlabGrowth &)> growth_hook;
+};
+
+/// Returns binary logarithm of the power of two value.
+constexpr size_t log2_pow2(size_t val) {
+    size_t res = 0;
+    while (val > 1) {
+        val >>= 1;
+        ++res;
+    }
+    return res;
+}
+
+/// Returns number of trailing zero bits, the value must be non zero.
+inline unsigned ctz64(uint64_t val) {
+#if defined(_MSC_VER)
+    unsigned long res;
+    _BitScanForward64(&res, val);
+    return res;
+#else
+    return __builtin_ctzll(val);
+#endif
+}
+
+/// Returns number of leading zero bits, the value must be non zero.
+inline unsigned clz64(uint64_t val) {
+#if defined(_MSC_VER)
+    unsigned long res;
+    _BitScanReverse64(&res, val);
+    return 63 - res;
+#else
+    return __builtin_clzll(val);
+#endif
+}
+
+/// Hints the processor to load the cache line of the address for writing, does nothing if not supported.
+inline void prefetch_write(const void *ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr, 1);
+#else
+    (void)ptr;
+#endif
+}
+
+/// Bitmap of occupied slots, 64 slots per word.
+/// Allows skip long runs of vacant slots by whole words.
+template <class Alloc = std::allocator<uint64_t>>
+class OccupancyBitmap {
+    std::vector<uint64_t, Alloc> words;
+
+public:
+    using allocator_type = Alloc;
+
+    /// Returned by find_prev() if there is no set bit.
+    static constexpr size_t npos = size_t(-1);
+
+    OccupancyBitmap() = default;
+    explicit OccupancyBitmap(const Alloc &alloc) : words(alloc) {}
+    OccupancyBitmap(const OccupancyBitmap &other, const Alloc &alloc) : words(other.words, alloc) {}
+
+    inline void swap(OccupancyBitmap &other) noexcept { words.swap(other.words); }
+
+    inline bool test(size_t pos) const { return (words[pos >> 6] >> (pos & 63)) & 1; }
+    inline const uint64_t* data() const { return words.data(); }
+    inline void set(size_t pos) { words[pos >> 6] |= uint64_t(1) << (pos & 63); }
+    inline void reset(size_t pos) { words[pos >> 6] &= ~(uint64_t(1) << (pos & 63)); }
+
+    /// Sets bits in the range [first, last).
+    void set_range(size_t first, size_t last) {
+        for (; first < last && (first & 63) != 0; ++first)
+            set(first);
+        for (; first + 64 <= last; first += 64)
+            words[first >> 6] = ~uint64_t(0);
+        for (; first < last; ++first)
+            set(first);
+    }
+
+    /// Makes bitmap cover the specified number of slots, new bits are zero.
+    inline void grow(size_t slots) {
+        if (words.size() << 6 < slots)
+            words.resize((slots + 63) >> 6);
+    }
+
+    inline void reserve(size_t slots) { words.reserve((slots + 63) >> 6); }
+
+    /// Makes bitmap cover only the specified number of slots and frees unused memory.
+    /// There must be no set bits at or after slots.
+    inline void shrink_to_fit(size_t slots) {
+        words.resize((slots + 63) >> 6);
+        words.shrink_to_fit();
+    }
+
+    /// Returns true if there are no set bits in the range [first, last).
+    inline bool none(size_t first, size_t last) const {
+        return find_next(first, last) == last;
+    }
+
+    /// Returns position of the first set bit at or after pos or end if there is no such bit before end.
+    /// Words after end aren't scanned, so end may be in the middle of the bitmap.
+    inline size_t find_next(size_t pos, size_t end) const {
+        if (pos >= end)
+            return end;
+
+        size_t i = pos >> 6;
+        uint64_t word = words[i] >> (pos & 63);
+        if (word != 0)
+            return std::min(end, pos + ctz64(word));
+
+        size_t end_word = std::min(words.size(), (end + 63) >> 6);
+        do {
+            if (++i >= end_word)
+                return end;
+            word = words[i];
+        } while (word == 0);
+        return std::min(end, (i << 6) + ctz64(word));
+    }
+
+    /// Returns position of the first zero bit at or after pos or end if there is no such bit before end.
+    inline size_t find_next_zero(size_t pos, size_t end) const {
+        if (pos >= end)
+            return end;
+
+        size_t i = pos >> 6;
+        uint64_t word = ~words[i] >> (pos & 63);
+        if (word != 0)
+            return std::min(end, pos + ctz64(word));
+
+        while (++i < words.size() && (i << 6) < end) {
+            word = ~words[i];
+            if (word != 0)
+                return std::min(end, (i << 6) + ctz64(word));
+        }
+        return end;
+    }
+
+    /// Returns position of the last set bit before pos or npos if there is no such bit.
+    inline size_t find_prev(size_t pos) const {
+        if (pos == 0)
+            return npos;
+
+        --pos;
+        size_t i = pos >> 6;
+        uint64_t word = words[i] & (~uint64_t(0) >> (63 - (pos & 63)));
+        while (word == 0) {
+            if (i == 0)
+                return npos;
+            word = words[--i];
+        }
+        return (i << 6) + 63 - clz64(word);
+    }
+};
+
+/// Contiguous pool of slots.
+/// If not enough capacity will relocating memory and moving all slots same logic as std::vector.
+/// Pool doesn't know which slots are occupied, so slots are relocated by the owner
+/// with function relocate(Slot &dst, Slot &src, size_t index) that moves the object leaving the source alive,
+/// and relocate.destroy(Slot &slot, size_t index) that destroys the object of the slot if it's occupied.
+/// Memory is allocated by Alloc, it is the base class to take no space when stateless.
+template <class Slot, class Alloc = std::allocator<Slot>>
+class ContiguousSlotPool : Alloc {
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+    Slot *slots = nullptr;
+    /// Number of constructed slots.
+    size_t count = 0;
+    size_t cap = 0;
+
+    inline Alloc& allocator() { return *this; }
+
+    /// Moves slots to the new memory and frees the old one.
+    /// Old objects are destroyed only after all are moved, so if moving throws, moved objects are destroyed,
+    /// the pool is unchanged and the new memory stays owned by the caller, same guarantee as std::vector.
+    template <class Relocate>
+    void relocate_to(Slot *new_slots, size_t new_cap, Relocate &relocate) {
+        size_t i = 0;
+        try {
+            for (; i < count; ++i)
+                relocate(*::new (static_cast<void*>(new_slots + i)) Slot(), slots[i], i);
+        } catch (...) {
+            while (i-- > 0)
+                relocate.destroy(new_slots[i], i);
+            throw;
+        }
+
+        for (i = 0; i < count; ++i)
+            relocate.destroy(slots[i], i);
+        if (slots)
+            AllocTraits::deallocate(allocator(), slots, cap);
+        slots = new_slots;
+        cap = new_cap;
+    }
+
+    /// Allocates the new memory and relocates slots to it, the memory is freed if relocating throws.
+    template <class Relocate>
+    void reallocate(size_t new_cap, Relocate &relocate) {
+        Slot *new_slots = AllocTraits::allocate(allocator(), new_cap);
+        try {
+            relocate_to(new_slots, new_cap, relocate);
+        } catch (...) {
+            AllocTraits::deallocate(allocator(), new_slots, new_cap);
+            throw;
+        }
+    }
+
+public:
+    ContiguousSlotPool() = default;
+    explicit ContiguousSlotPool(const Alloc &alloc) : Alloc(alloc) {}
+
+    ContiguousSlotPool(ContiguousSlotPool &&other) noexcept
+        : Alloc(std::move(other.allocator()))
+        , slots(std::exchange(other.slots, nullptr))
+        , count(std::exchange(other.count, 0))
+        , cap(std::exchange(other.cap, 0)) {
+    }
+
+    ContiguousSlotPool& operator=(ContiguousSlotPool &&other) = delete;
+
+    ~ContiguousSlotPool() {
+        if (slots)
+            AllocTraits::deallocate(allocator(), slots, cap);
+    }
+
+    inline const Alloc& get_allocator() const { return *this; }
+
+    /// Swaps slots with other pool, allocators are swapped only if they propagate on swap.
+    void swap(ContiguousSlotPool &other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value)
+            std::swap(allocator(), other.allocator());
+        std::swap(slots, other.slots);
+        std::swap(count, other.count);
+        std::swap(cap, other.cap);
+    }
+
+    /// Frees own memory, slots must be destroyed, then takes slots and the allocator of other pool.
+    /// Used on move assignment when the allocator propagates on move assignment.
+    void move_assign(ContiguousSlotPool &other) noexcept {
+        if (slots)
+            AllocTraits::deallocate(allocator(), slots, cap);
+        allocator() = std::move(other.allocator());
+        slots = std::exchange(other.slots, nullptr);
+        count = std::exchange(other.count, 0);
+        cap = std::exchange(other.cap, 0);
+    }
+
+    inline Slot& operator[](size_t i) { return slots[i]; }
+    inline const Slot& operator[](size_t i) const { return slots[i]; }
+
+    inline size_t size() const { return count; }
+    inline size_t capacity() const { return cap; }
+
+    /// Forgets slots at and after the position, they must be vacant. Memory is kept.
+    inline void truncate(size_t size) { count = size; }
+
+    /// Reallocates memory to fit only constructed slots.
+    template <class Relocate>
+    void shrink_to_fit(Relocate &&relocate) {
+        if (cap == count)
+            return;
+
+        if (count == 0) {
+            AllocTraits::deallocate(allocator(), slots, cap);
+            slots = nullptr;
+            cap = 0;
+        } else {
+            reallocate(count, relocate);
+        }
+    }
+
+    /// Allocates memory for the specified number of slots.
+    template <class Relocate>
+    void reserve(size_t capacity, Relocate &&relocate) {
+        if (capacity > cap)
+            reallocate(capacity, relocate);
+    }
+
+    /// Appends a new slot and fills it with construct(Slot &slot).
+    /// On growth the new slot is filled before relocating others,
+    /// so arguments of construct may refer to objects in the pool.
+    /// If relocating throws, the new slot is destroyed by relocate.destroy(slot, size()).
+    template <class Construct, class Relocate>
+    inline Slot& push_back(Construct &&construct, Relocate &&relocate) {
+        if (count < cap) {
+            Slot *slot = ::new (static_cast<void*>(slots + count)) Slot();
+            construct(*slot);
+            ++count;
+            return *slot;
+        }
+
+        size_t new_cap = cap == 0 ? 1 : cap * 2;
+        Slot *new_slots = AllocTraits::allocate(allocator(), new_cap);
+        Slot *slot = ::new (static_cast<void*>(new_slots + count)) Slot();
+        try {
+            construct(*slot);
+            try {
+                relocate_to(new_slots, new_cap, relocate);
+            } catch (...) {
+                relocate.destroy(*slot, count);
+                throw;
+            }
+        } catch (...) {
+            AllocTraits::deallocate(allocator(), new_slots, new_cap);
+            throw;
+        }
+        ++count;
+        return *slot;
+    }
+};
+
+/// Paged pool of slots.
+/// Slots are stored in fixed size pages listed in the page directory.
+/// Growing allocates only a new page, so slots are never relocated.
+/// Key to slot is O(1): page number is high bits of the key and position in the page is low bits.
+/// Pages and the page directory are allocated by Alloc.
+template <class Slot, size_t PageSize, class Alloc = std::allocator<Slot>>
+class PagedSlotPool {
+    static_assert(PageSize != 0 && (PageSize & (PageSize - 1)) == 0, "Page size must be a power of two.");
+
+    static constexpr size_t page_shift = log2_pow2(PageSize);
+    static constexpr size_t page_mask = PageSize - 1;
+
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using DirectoryAlloc = typename AllocTraits::template rebind_alloc<Slot*>;
+
+    /// Directory of pages, each page is an uninitialized memory for PageSize slots.
+    std::vector<Slot*, DirectoryAlloc> pages;
+    /// Number of constructed slots.
+    size_t count = 0;
+
+    inline Alloc allocator() const { return Alloc(pages.get_allocator()); }
+
+public:
+    PagedSlotPool() = default;
+    explicit PagedSlotPool(const Alloc &alloc) : pages(DirectoryAlloc(alloc)) {}
+
+    PagedSlotPool(PagedSlotPool &&other) noexcept
+        : pages(std::move(other.pages))
+        , count(std::exchange(other.count, 0)) {
+        other.pages.clear();
+    }
+
+    PagedSlotPool& operator=(PagedSlotPool &&other) = delete;
+
+    ~PagedSlotPool() {
+        Alloc alloc = allocator();
+        for (Slot *page : pages)
+            AllocTraits::deallocate(alloc, page, PageSize);
+    }
+
+    inline Alloc get_allocator() const { return allocator(); }
+
+    /// Swaps slots with other pool, allocators are swapped only if they propagate on swap.
+    void swap(PagedSlotPool &other) noexcept {
+        pages.swap(other.pages);
+        std::swap(count, other.count);
+    }
+
+    /// Frees own pages, slots must be destroyed, then takes pages and the allocator of other pool.
+    /// Used on move assignment when the allocator propagates on move assignment.
+    void move_assign(PagedSlotPool &other) noexcept {
+        Alloc alloc = allocator();
+        for (Slot *page : pages)
+            AllocTraits::deallocate(alloc, page, PageSize);
+        pages = std::move(other.pages);
+        other.pages.clear();
+        count = std::exchange(other.count, 0);
+    }
+
+    inline Slot& operator[](size_t i) { return pages[i >> page_shift][i & page_mask]; }
+    inline const Slot& operator[](size_t i) const { return pages[i >> page_shift][i & page_mask]; }
+
+    inline size_t size() const { return count; }
+    inline size_t capacity() const { return pages.size() * PageSize; }
+
+    /// Forgets slots at and after the position, they must be vacant. Pages are kept.
+    inline void truncate(size_t size) { count = size; }
+
+    /// Frees pages without constructed slots and unused memory of the page directory.
+    /// Slots are never relocated, relocate is never called.
+    template <class Relocate>
+    void shrink_to_fit(Relocate &&) {
+        size_t pages_num = (count + page_mask) >> page_shift;
+        Alloc alloc = allocator();
+        while (pages.size() > pages_num) {
+            AllocTraits::deallocate(alloc, pages.back(), PageSize);
+            pages.pop_back();
+        }
+        pages.shrink_to_fit();
+    }
+
+    /// Returns memory of the page to the OS, the page stays usable and the released memory reads as zeros.
+    /// Only whole OS pages before the last slot of the page are released, so the last slot keeps contents.
+    /// Does nothing on platforms without madvise().
+    void release_page(size_t page) {
+#if defined(__unix__) || defined(__APPLE__)
+        static const uintptr_t os_page = uintptr_t(::sysconf(_SC_PAGESIZE));
+        uintptr_t begin = (reinterpret_cast<uintptr_t>(pages[page]) + os_page - 1) & ~(os_page - 1);
+        uintptr_t end = reinterpret_cast<uintptr_t>(pages[page] + PageSize - 1) & ~(os_page - 1);
+        if (begin < end)
+            ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#else
+        (void)page;
+#endif
+    }
+
+    /// Allocates pages for the specified number of slots.
+    /// Only the page directory may be relocated, relocate is never called.
+    template <class Relocate>
+    void reserve(size_t capacity, Relocate &&) {
+        size_t pages_num = (capacity + page_mask) >> page_shift;
+        pages.reserve(pages_num);
+        Alloc alloc = allocator();
+        while (pages.size() < pages_num)
+            pages.push_back(AllocTraits::allocate(alloc, PageSize));
+    }
+
+    /// Appends a new slot and fills it with construct(Slot &slot).
+    template <class Construct, class Relocate>
+    inline Slot& push_back(Construct &&construct, Relocate &&) {
+        if (count == capacity()) {
+            Alloc alloc = allocator();
+            Slot *page = AllocTraits::allocate(alloc, PageSize);
+            try {
+                pages.push_back(page);
+            } catch (...) {
+                AllocTraits::deallocate(alloc, page, PageSize);
+                throw;
+            }
+        }
+
+        Slot *slot = ::new (static_cast<void*>(&(*this)[count])) Slot();
+        construct(*slot);
+        ++count;
+        return *slot;
+    }
+};
+
+/// Pool of slots for specified page size.
+template <class Slot, size_t PageSize, class Alloc = std::allocator<Slot>>
+using SlotPool = std::conditional_t<PageSize == 0, ContiguousSlotPool<Slot, Alloc>, PagedSlotPool<Slot, PageSize, Alloc>>;
+
+/// Generation of the slot, odd when slot is occupied and even when vacant.
+/// Empty when generations are disabled (Key is void).
+template <class Key>
+struct SlotGeneration {
+    Key generation = 0;
+
+    inline void next_generation() { ++generation; }
+};
+
+template <>
+struct SlotGeneration<void> {
+    inline void next_generation() {}
+};
+
+/// Slot of the slab element, raw storage of the object without any flags.
+/// Occupied slot stores the object, vacant slot stores the link to the next vacant slot,
+/// so list of vacant slots is threaded through the slots themselves.
+/// Whether the slot is occupied is known only by the owner (see OccupancyBitmap),
+/// so the owner constructs and destroys objects.
+template <class T, class Key, bool Generational>
+struct Slot : SlotGeneration<std::conditional_t<Generational, Key, void>> {
+    using Generation = SlotGeneration<std::conditional_t<Generational, Key, void>>;
+
+    union {
+        T value;
+        Key next_vacant;
+    };
+
+    /// Offset of the value in the slot, after the generation if generations are enabled.
+    static constexpr size_t value_offset = Generational ? (sizeof(Key) + alignof(T) - 1) / alignof(T) * alignof(T) : 0;
+
+    /// Constructs vacant slot without link.
+    Slot() {}
+    Slot(const Slot &) = delete;
+    Slot& operator=(const Slot &) = delete;
+    ~Slot() {}
+
+    /// Constructs the object in the vacant slot.
+    template <class... Args>
+    inline void emplace(Args&&... args) {
+        ::new (static_cast<void*>(&value)) T(std::forward<Args>(args)...);
+        this->next_generation();
+    }
+
+    /// Destroys the object and links the slot to the next vacant slot.
+    inline void vacate(Key next) {
+        value.~T();
+        next_vacant = next;
+        this->next_generation();
+    }
+
+    /// Copies or moves (if other is rvalue) the other slot to this new slot.
+    /// The object of the other slot stays alive.
+    template <class Other>
+    void construct_from(Other &&other, bool occupied) {
+        static_cast<Generation&>(*this) = other;
+        if (occupied)
+            ::new (static_cast<void*>(&value)) T(std::forward<Other>(other).value);
+        else
+            next_vacant = other.next_vacant;
+    }
+
+    /// Moves (or copies if moving may throw) the other slot to this new slot.
+    /// The object of the other slot stays alive.
+    void relocate_from(Slot &other, bool occupied) {
+        static_cast<Generation&>(*this) = other;
+        if (occupied)
+            ::new (static_cast<void*>(&value)) T(std::move_if_noexcept(other.value));
+        else
+            next_vacant = other.next_vacant;
+    }
+};
+
+/// Random access iterator over objects of contiguous slots, the object of every slot is Stride bytes after the previous one.
+template <class T, size_t Stride>
+class StridedIterator {
+    char *ptr = nullptr;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = T;
+    using pointer           = T*;
+    using reference         = T&;
+
+    StridedIterator() = default;
+    explicit StridedIterator(T *obj) : ptr(reinterpret_cast<char*>(obj)) {}
+
+    inline reference operator*() const { return *reinterpret_cast<T*>(ptr); }
+    inline pointer operator->() const { return reinterpret_cast<T*>(ptr); }
+    inline reference operator[](difference_type n) const { return *reinterpret_cast<T*>(ptr + n * difference_type(Stride)); }
+
+    inline StridedIterator& operator++() { ptr += Stride; return *this; }
+    inline StridedIterator& operator--() { ptr -= Stride; return *this; }
+    inline StridedIterator operator++(int) { StridedIterator res = *this; ptr += Stride; return res; }
+    inline StridedIterator operator--(int) { StridedIterator res = *this; ptr -= Stride; return res; }
+    inline StridedIterator& operator+=(difference_type n) { ptr += n * difference_type(Stride); return *this; }
+    inline StridedIterator& operator-=(difference_type n) { ptr -= n * difference_type(Stride); return *this; }
+
+    friend inline StridedIterator operator+(StridedIterator it, difference_type n) { return it += n; }
+    friend inline StridedIterator operator+(difference_type n, StridedIterator it) { return it += n; }
+    friend inline StridedIterator operator-(StridedIterator it, difference_type n) { return it -= n; }
+    friend inline difference_type operator-(const StridedIterator &a, const StridedIterator &b) {
+        return (a.ptr - b.ptr) / difference_type(Stride);
+    }
+
+    friend inline bool operator==(const StridedIterator &a, const StridedIterator &b) { return a.ptr == b.ptr; }
+    friend inline bool operator!=(const StridedIterator &a, const StridedIterator &b) { return a.ptr != b.ptr; }
+    friend inline bool operator<(const StridedIterator &a, const StridedIterator &b) { return a.ptr < b.ptr; }
+    friend inline bool operator>(const StridedIterator &a, const StridedIterator &b) { return a.ptr > b.ptr; }
+    friend inline bool operator<=(const StridedIterator &a, const StridedIterator &b) { return a.ptr <= b.ptr; }
+    friend inline bool operator>=(const StridedIterator &a, const StridedIterator &b) { return a.ptr >= b.ptr; }
+};
+
+/// Kernels over arithmetic values of slots for whole blocks of 64 slots stored contiguously.
+/// Slot i of the block b starts at slots + (b * 64 + i) * Stride and its value is at Offset in the slot,
+/// occupancy of the block is words[b]. Values of vacant slots are read but never used.
+/// Portable kernels process a block in lanes with independent accumulators, so compilers vectorize them.
+namespace portable {
+
+constexpr size_t lanes = 8;
+
+template <class T, size_t Stride, size_t Offset>
+inline T value_at(const char *slots, size_t index) {
+    T val;
+    std::memcpy(&val, slots + index * Stride + Offset, sizeof(T));
+    return val;
+}
+
+/// Calls f(lane, value, occupied) for all slots of the block, occupied is always true for full blocks.
+template <class T, size_t Stride, size_t Offset, class F>
+inline void for_block(const char *slots, size_t block, uint64_t word, F &f) {
+    const char *p = slots + block * 64 * Stride;
+    if (word == ~uint64_t(0)) {
+        for (size_t i = 0; i < 64; i += lanes) {
+            for (size_t j = 0; j < lanes; ++j)
+                f(j, value_at<T, Stride, Offset>(p, i + j), true);
+        }
+    } else {
+        for (size_t i = 0; i < 64; i += lanes) {
+            for (size_t j = 0; j < lanes; ++j)
+                f(j, value_at<T, Stride, Offset>(p, i + j), ((word >> (i + j)) & 1) != 0);
+        }
+    }
+}
+
+template <class T, size_t Stride, size_t Offset>
+T sum(const char *slots, const uint64_t *words, size_t blocks) {
+    T acc[lanes] = {};
+    auto add = [&](size_t lane, T val, bool occupied) { acc[lane] += occupied ? val : T(0); };
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] != 0)
+            for_block<T, Stride, Offset>(slots, b, words[b], add);
+    }
+    T res = 0;
+    for (T val : acc)
+        res += val;
+    return res;
+}
+
+template <class T, size_t Stride, size_t Offset>
+size_t count(const char *slots, const uint64_t *words, size_t blocks, T value) {
+    size_t acc[lanes] = {};
+    auto match = [&](size_t lane, T val, bool occupied) { acc[lane] += occupied && val == value; };
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] != 0)
+            for_block<T, Stride, Offset>(slots, b, words[b], match);
+    }
+    size_t res = 0;
+    for (size_t n : acc)
+        res += n;
+    return res;
+}
+
+/// Returns the first block with an occupied slot equal to the value or blocks if there is no such block.
+template <class T, size_t Stride, size_t Offset>
+size_t find_block(const char *slots, const uint64_t *words, size_t blocks, T value) {
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] == 0)
+            continue;
+        bool acc[lanes] = {};
+        auto match = [&](size_t lane, T val, bool occupied) { acc[lane] |= occupied && val == value; };
+        for_block<T, Stride, Offset>(slots, b, words[b], match);
+        if (std::find(acc, acc + lanes, true) != acc + lanes)
+            return b;
+    }
+    return blocks;
+}
+
+/// Returns the minimum (Max is false) or the maximum of init and values of occupied slots.
+template <class T, size_t Stride, size_t Offset, bool Max>
+T extremum(const char *slots, const uint64_t *words, size_t blocks, T init) {
+    T acc[lanes];
+    std::fill(acc, acc + lanes, init);
+    auto select = [&](size_t lane, T val, bool occupied) {
+        bool better = Max ? acc[lane] < val : val < acc[lane];
+        acc[lane] = occupied && better ? val : acc[lane];
+    };
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] != 0)
+            for_block<T, Stride, Offset>(slots, b, words[b], select);
+    }
+    T res = init;
+    for (T val : acc)
+        res = (Max ? res < val : val < res) ? val : res;
+    return res;
+}
+
+} // namespace portable
+
+#if SLAB_AVX2
+
+/// Returns true if the CPU supports AVX2, checked once.
+inline bool has_avx2() {
+    static const bool res = __builtin_cpu_supports("avx2");
+    return res;
+}
+
+/// AVX2 kernels for 32 bit values in slots of 4 or 8 bytes and 64 bit values in slots of 8 bytes.
+/// Vacant slots are excluded by lane masks made from occupancy bits.
+namespace avx2 {
+
+template <class T, size_t Stride, size_t Offset>
+constexpr bool supported = (sizeof(T) == 4 && ((Stride == 4 && Offset == 0) || (Stride == 8 && Offset % 4 == 0)))
+                           || (sizeof(T) == 8 && Stride == 8 && Offset == 0);
+
+/// Loads values of 8 slots for 32 bit values or 4 slots for 64 bit values and masks of occupied lanes.
+template <class T, size_t Stride, size_t Offset>
+struct Lanes {
+    static constexpr size_t width = 32 / sizeof(T);
+
+    /// Values of width slots starting at p. Values of slots of 8 bytes are gathered
+    /// from two loads by the shuffle in the lane order of slots 0 1 4 5 2 3 6 7, masks follow it.
+    SLAB_AVX2_TARGET static inline __m256i load(const char *p) {
+        if constexpr (Stride == sizeof(T)) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        } else {
+            __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+            __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)));
+            if constexpr (Offset == 0)
+                return _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            else
+                return _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+
+    /// All ones in lanes of occupied slots by width occupancy bits.
+    SLAB_AVX2_TARGET static inline __m256i mask(uint64_t bits) {
+        if constexpr (sizeof(T) == 8) {
+            __m256i flags = _mm256_setr_epi64x(1, 2, 4, 8);
+            return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(int64_t(bits)), flags), flags);
+        } else {
+            __m256i flags = Stride == 4 ? _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)
+                                        : _mm256_setr_epi32(1, 2, 16, 32, 4, 8, 64, 128);
+            return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int(bits)), flags), flags);
+        }
+    }
+};
+
+/// Operations on vectors of values of type T.
+template <class T>
+struct Ops {
+    SLAB_AVX2_TARGET static inline __m256i set1(T val) {
+        if constexpr (sizeof(T) == 8) {
+            int64_t bits;
+            std::memcpy(&bits, &val, sizeof(bits));
+            return _mm256_set1_epi64x(bits);
+        } else {
+            int32_t bits;
+            std::memcpy(&bits, &val, sizeof(bits));
+            return _mm256_set1_epi32(bits);
+        }
+    }
+
+    SLAB_AVX2_TARGET static inline __m256i add(__m256i a, __m256i b) {
+        if constexpr (std::is_same_v<T, float>)
+            return _mm256_castps_si256(_mm256_add_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+        else if constexpr (std::is_same_v<T, double>)
+            return _mm256_castpd_si256(_mm256_add_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+        else if constexpr (sizeof(T) == 8)
+            return _mm256_add_epi64(a, b);
+        else
+            return _mm256_add_epi32(a, b);
+    }
+
+    /// All ones in lanes where a == b.
+    SLAB_AVX2_TARGET static inline __m256i eq(__m256i a, __m256i b) {
+        if constexpr (std::is_same_v<T, float>)
+            return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+        else if constexpr (std::is_same_v<T, double>)
+            return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+        else if constexpr (sizeof(T) == 8)
+            return _mm256_cmpeq_epi64(a, b);
+        else
+            return _mm256_cmpeq_epi32(a, b);
+    }
+
+    /// All ones in lanes where a < b, unsigned values are compared as signed with flipped sign bits.
+    SLAB_AVX2_TARGET static inline __m256i less(__m256i a, __m256i b) {
+        if constexpr (std::is_same_v<T, float>) {
+            return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_LT_OQ));
+        } else if constexpr (std::is_same_v<T, double>) {
+            return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_LT_OQ));
+        } else if constexpr (sizeof(T) == 8) {
+            if constexpr (std::is_unsigned_v<T>) {
+                __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+                return _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+            } else {
+                return _mm256_cmpgt_epi64(b, a);
+            }
+        } else {
+            if constexpr (std::is_unsigned_v<T>) {
+                __m256i sign = _mm256_set1_epi32(INT32_MIN);
+                return _mm256_cmpgt_epi32(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+            } else {
+                return _mm256_cmpgt_epi32(b, a);
+            }
+        }
+    }
+};
+
+/// Calls op(values, mask) for vectors of the block with occupied slots.
+template <class T, size_t Stride, size_t Offset, class Op>
+SLAB_AVX2_TARGET inline void for_block(const char *slots, size_t block, uint64_t word, Op &op) {
+    using L = Lanes<T, Stride, Offset>;
+    constexpr uint64_t lane_bits = (uint64_t(1) << L::width) - 1;
+    const char *p = slots + block * 64 * Stride + (Stride == sizeof(T) ? Offset : 0);
+    if (word == ~uint64_t(0)) {
+        for (size_t i = 0; i < 64; i += L::width)
+            op(L::load(p + i * Stride), _mm256_set1_epi32(-1));
+    } else {
+        for (size_t i = 0; i < 64; i += L::width) {
+            uint64_t bits = (word >> i) & lane_bits;
+            if (bits != 0)
+                op(L::load(p + i * Stride), L::mask(bits));
+        }
+    }
+}
+
+/// Returns the lanes of the vector as array.
+template <class T>
+struct Unpacked {
+    T vals[32 / sizeof(T)];
+
+    SLAB_AVX2_TARGET explicit Unpacked(__m256i v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(vals), v);
+    }
+};
+
+template <class T>
+struct SumOp {
+    __m256i acc;
+
+    SLAB_AVX2_TARGET inline void operator()(__m256i v, __m256i mask) {
+        acc = Ops<T>::add(acc, _mm256_and_si256(v, mask));
+    }
+};
+
+template <class T>
+struct CountOp {
+    __m256i needle;
+    /// Number of matched bytes.
+    size_t bytes = 0;
+
+    SLAB_AVX2_TARGET inline void operator()(__m256i v, __m256i mask) {
+        __m256i eq = _mm256_and_si256(Ops<T>::eq(v, needle), mask);
+        bytes += size_t(__builtin_popcount(uint32_t(_mm256_movemask_epi8(eq))));
+    }
+};
+
+template <class T>
+struct AnyOp {
+    __m256i needle;
+    __m256i any;
+
+    SLAB_AVX2_TARGET inline void operator()(__m256i v, __m256i mask) {
+        any = _mm256_or_si256(any, _mm256_and_si256(Ops<T>::eq(v, needle), mask));
+    }
+};
+
+template <class T, bool Max>
+struct ExtremumOp {
+    __m256i acc;
+
+    SLAB_AVX2_TARGET inline void operator()(__m256i v, __m256i mask) {
+        __m256i better = _mm256_and_si256(Max ? Ops<T>::less(acc, v) : Ops<T>::less(v, acc), mask);
+        acc = _mm256_blendv_epi8(acc, v, better);
+    }
+};
+
+template <class T, size_t Stride, size_t Offset>
+SLAB_AVX2_TARGET T sum(const char *slots, const uint64_t *words, size_t blocks) {
+    SumOp<T> op { _mm256_setzero_si256() };
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] != 0)
+            for_block<T, Stride, Offset>(slots, b, words[b], op);
+    }
+    T res = 0;
+    for (T val : Unpacked<T>(op.acc).vals)
+        res += val;
+    return res;
+}
+
+template <class T, size_t Stride, size_t Offset>
+SLAB_AVX2_TARGET size_t count(const char *slots, const uint64_t *words, size_t blocks, T value) {
+    CountOp<T> op { Ops<T>::set1(value) };
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] != 0)
+            for_block<T, Stride, Offset>(slots, b, words[b], op);
+    }
+    return op.bytes / sizeof(T);
+}
+
+template <class T, size_t Stride, size_t Offset>
+SLAB_AVX2_TARGET size_t find_block(const char *slots, const uint64_t *words, size_t blocks, T value) {
+    __m256i needle = Ops<T>::set1(value);
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] == 0)
+            continue;
+        AnyOp<T> op { needle, _mm256_setzero_si256() };
+        for_block<T, Stride, Offset>(slots, b, words[b], op);
+        if (!_mm256_testz_si256(op.any, op.any))
+            return b;
+    }
+    return blocks;
+}
+
+template <class T, size_t Stride, size_t Offset, bool Max>
+SLAB_AVX2_TARGET T extremum(const char *slots, const uint64_t *words, size_t blocks, T init) {
+    ExtremumOp<T, Max> op { Ops<T>::set1(init) };
+    for (size_t b = 0; b < blocks; ++b) {
+        if (words[b] != 0)
+            for_block<T, Stride, Offset>(slots, b, words[b], op);
+    }
+    T res = init;
+    for (T val : Unpacked<T>(op.acc).vals)
+        res = (Max ? res < val : val < res) ? val : res;
+    return res;
+}
+
+} // namespace avx2
+
+#endif
+
+/// Kernels with runtime dispatch: AVX2 if the CPU supports it and the slot layout allows, otherwise portable.
+template <class T, size_t Stride, size_t Offset>
+struct ArithmeticKernels {
+    /// Returns true if AVX2 kernels are used.
+    static inline bool use_avx2() {
+#if SLAB_AVX2
+        if constexpr (avx2::supported<T, Stride, Offset>)
+            return has_avx2();
+#endif
+        return false;
+    }
+
+    static T sum(const char *slots, const uint64_t *words, size_t blocks) {
+#if SLAB_AVX2
+        if constexpr (avx2::supported<T, Stride, Offset>) {
+            if (use_avx2())
+                return avx2::sum<T, Stride, Offset>(slots, words, blocks);
+        }
+#endif
+        return portable::sum<T, Stride, Offset>(slots, words, blocks);
+    }
+
+    static size_t count(const char *slots, const uint64_t *words, size_t blocks, T value) {
+#if SLAB_AVX2
+        if constexpr (avx2::supported<T, Stride, Offset>) {
+            if (use_avx2())
+                return avx2::count<T, Stride, Offset>(slots, words, blocks, value);
+        }
+#endif
+        return portable::count<T, Stride, Offset>(slots, words, blocks, value);
+    }
+
+    static size_t find_block(const char *slots, const uint64_t *words, size_t blocks, T value) {
+#if SLAB_AVX2
+        if constexpr (avx2::supported<T, Stride, Offset>) {
+            if (use_avx2())
+                return avx2::find_block<T, Stride, Offset>(slots, words, blocks, value);
+        }
+#endif
+        return portable::find_block<T, Stride, Offset>(slots, words, blocks, value);
+    }
+
+    template <bool Max>
+    static T extremum(const char *slots, const uint64_t *words, size_t blocks, T init) {
+#if SLAB_AVX2
+        if constexpr (avx2::supported<T, Stride, Offset>) {
+            if (use_avx2())
+                return avx2::extremum<T, Stride, Offset, Max>(slots, words, blocks, init);
+        }
+#endif
+        return portable::extremum<T, Stride, Offset, Max>(slots, words, blocks, init);
+    }
+};
+
+} // namespace slab_detail
+
 /// Container with slab allocator logic.
 /// Allows fast insert, look-up and remove elements. Avoids allocations.
 /// https://en.wikipedia.org/wiki/Slab_allocation
-template <class T>
-class Slab {
+///
+/// Configuration is set by Traits, see SlabTraits.
+/// All memory of slots, page directory and occupancy bitmap is allocated by Allocator.
+template <class T, class Traits = SlabTraits, class Allocator = std::allocator<T>>
+class Slab : slab_detail::StatsStorage<Traits::stats> {
+public:
+    /// Unsigned integer type of keys.
+    using key_type = typename Traits::key_type;
+    using allocator_type = Allocator;
+
+private:
+    static_assert(std::is_unsigned_v<key_type>, "Key type must be an unsigned integer.");
+
+    static constexpr unsigned generation_bits = Traits::generation_bits;
+    static_assert(generation_bits < std::numeric_limits<key_type>::digits, "Generation bits must leave bits for the slot index.");
+
+    static constexpr bool generational = generation_bits != 0;
+    /// Number of low key bits used for the slot index.
+    static constexpr unsigned index_bits = std::numeric_limits<key_type>::digits - generation_bits;
+    static constexpr key_type index_mask = std::numeric_limits<key_type>::max() >> generation_bits;
+
+    using Slot = slab_detail::Slot<T, key_type, generational>;
+
+    using AllocTraits = std::allocator_traits<Allocator>;
+    using SlotAllocator = typename AllocTraits::template rebind_alloc<Slot>;
+    using Bitmap = slab_detail::OccupancyBitmap<typename AllocTraits::template rebind_alloc<uint64_t>>;
+
+    /// Index of the list end.
+    static constexpr key_type no_vacant = std::numeric_limits<key_type>::max();
+
     /// Slots of elements.
-    std::vector<std::optional<T>> slots_pool;
-    /// Stack of removed elements slots keys for reusing them for next inserted elements.
-    std::vector<size_t> stack_of_removed;
+    slab_detail::SlotPool<Slot, Traits::page_size, SlotAllocator> slots_pool;
+    /// Bitmap of occupied slots, the only place where occupancy of slots is stored.
+    Bitmap occupancy;
+    /// Index of the vacant slot reused by the next insert, head of the list of vacant slots.
+    /// With SlabReuse::lowest vacant slots aren't linked, it's the lowest vacant slot
+    /// and following ones are found in the occupancy bitmap.
+    key_type vacant_head = no_vacant;
+    /// Index of the last slot of the list of vacant slots, valid only if the list isn't empty.
+    key_type vacant_tail = no_vacant;
+    /// Number of vacant slots, including slots held by vacant entries.
+    size_t vacant_count = 0;
+    /// Number of vacant slots held by vacant entries, they are not in the list of vacant slots.
+    size_t reserved_count = 0;
+    /// Generation of slots appended after dropping trailing slots by trim(),
+    /// not less than generations of dropped slots, so their stale keys stay rejected.
+    key_type generation_floor = 0;
+
+    static constexpr bool paged = Traits::page_size != 0;
+    static constexpr bool stats_enabled = Traits::stats;
+    static constexpr SlabReuse reuse = Traits::reuse;
+
+    /// Returns the value of next_vacant of the vacant slot by the index linked to the next slot, and vice versa.
+    /// The link is xor with the following index, so zero means the following slot:
+    /// memory of a released page reads as zeros and stays the valid part of the list.
+    static inline key_type vacant_link(key_type next, size_t index) {
+        return key_type(next ^ key_type(index + 1));
+    }
+
+    /// Returns the slot index from the key.
+    static inline size_t key_index(key_type key) {
+        return key & index_mask;
+    }
+
+    /// Returns the key of the slot by the index.
+    inline key_type slot_key(size_t index) const {
+        if constexpr (generational)
+            return key_type(index | (size_t(slots_pool[index].generation) << index_bits));
+        else
+            return key_type(index);
+    }
+
+    /// Returns the key what will be assigned to the object constructed in the vacant or new slot by the index.
+    inline key_type vacant_slot_key(size_t index) const {
+        if constexpr (generational) {
+            size_t generation = (index < slots_pool.size() ? size_t(slots_pool[index].generation) : size_t(generation_floor)) + 1;
+            return key_type(index | (generation << index_bits));
+        } else {
+            return key_type(index);
+        }
+    }
+
+    /// Moves slots on relocation of the contiguous pool and destroys objects of occupied slots.
+    /// Methods are templates, so they aren't instantiated for paged pool and non movable objects.
+    struct Relocator {
+        const Bitmap &occupancy;
+
+        template <class S>
+        inline void operator()(S &dst, S &src, size_t index) const {
+            dst.relocate_from(src, occupancy.test(index));
+        }
+
+        template <class S>
+        inline void destroy(S &slot, size_t index) const {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                if (occupancy.test(index))
+                    slot.value.~T();
+            }
+        }
+    };
+
+    /// Returns the relocator of slots of the contiguous pool.
+    inline Relocator relocator() const {
+        return Relocator { occupancy };
+    }
+
+    /// Destroys all stored objects.
+    void destroy_objects() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = occupancy.find_next(0, slots_pool.size()); i < slots_pool.size(); i = occupancy.find_next(i + 1, slots_pool.size()))
+                slots_pool[i].value.~T();
+        }
+    }
+
+    /// Sets the generation of the new slot.
+    inline void init_generation(Slot &slot) const {
+        if constexpr (generational)
+            slot.generation = generation_floor;
+    }
+
+    /// Runs grow() that makes the storage fit required slots. With statistics, if the storage grows,
+    /// counts the reallocation and reports the growth to the growth hook.
+    template <class Grow>
+    inline void track_growth(size_t required, Grow &&grow) {
+        if constexpr (stats_enabled) {
+            if (required > slots_pool.capacity()) {
+                SlabGrowth growth { slots_pool.capacity(), 0, paged ? 0 : slots_pool.size() * sizeof(Slot), {} };
+                auto start = std::chrono::steady_clock::now();
+                grow();
+                growth.duration = std::chrono::steady_clock::now() - start;
+                growth.new_capacity = slots_pool.capacity();
+                count_reallocation(growth.bytes_moved);
+                if (this->growth_hook)
+                    this->growth_hook(growth);
+                return;
+            }
+        }
+        grow();
+    }
+
+    /// Counts the reallocation of contiguous storage.
+    inline void count_reallocation(size_t bytes_moved) {
+        if constexpr (stats_enabled && !paged) {
+            ++this->counters.reallocations;
+            this->counters.bytes_moved += bytes_moved;
+        }
+    }
+
+    /// Counts inserted objects and updates the high-water mark.
+    inline void count_inserts(size_t reused, size_t appended) {
+        if constexpr (stats_enabled) {
+            this->counters.reused_slots += reused;
+            this->counters.appended_slots += appended;
+            this->counters.high_water_mark = std::max(this->counters.high_water_mark, size());
+        }
+    }
+
+    /// Returns the number of slots in the longest run of vacant slots, runs are skipped by the bitmap at once.
+    size_t longest_vacant_run() const {
+        size_t res = 0;
+        size_t end = slots_pool.size();
+        for (size_t i = occupancy.find_next_zero(0, end); i < end; ) {
+            size_t next = occupancy.find_next(i, end);
+            res = std::max(res, next - i);
+            i = occupancy.find_next_zero(next, end);
+        }
+        return res;
+    }
+
+    /// Constructs the object in the new slot with construct(Slot &slot, key_type key) and returns the key.
+    template <class Construct>
+    inline key_type append_slot(Construct &&construct) {
+        size_t index = slots_pool.size();
+        if (index >= max_size())
+            throw std::length_error("Slab keys overflow");
+
+        key_type key = vacant_slot_key(index);
+        // the bit is set before relocating other slots, so the relocator destroys the new object if relocating throws
+        occupancy.grow(index + 1);
+        auto construct_slot = [&](Slot &slot) {
+            init_generation(slot);
+            construct(slot, key);
+            occupancy.set(index);
+        };
+        try {
+            if constexpr (stats_enabled)
+                track_growth(index + 1, [&] { slots_pool.push_back(construct_slot, relocator()); });
+            else
+                slots_pool.push_back(construct_slot, relocator());
+        } catch (...) {
+            occupancy.reset(index);
+            throw;
+        }
+        count_inserts(0, 1);
+        return key;
+    }
+
+    /// Returns the vacant slot reused after the head slot by the index, that is being taken from the list.
+    inline key_type next_vacant_of(size_t index) const {
+        if constexpr (reuse == SlabReuse::lowest) {
+            // vacant slots above the head, skipping slots of vacant entries
+            if (vacant_count - reserved_count == 1)
+                return no_vacant;
+            size_t end = slots_pool.size();
+            for (size_t i = occupancy.find_next_zero(index + 1, end); i < end; i = occupancy.find_next_zero(i + 1, end)) {
+                if (slots_pool[i].next_vacant != no_vacant)
+                    return key_type(i);
+            }
+            return no_vacant;
+        } else {
+            return vacant_link(slots_pool[index].next_vacant, index);
+        }
+    }
+
+    /// Constructs the object in the head slot of the vacant slots list with construct(Slot &slot, key_type key)
+    /// and returns the key. The list must not be empty.
+    template <class Construct>
+    inline key_type reuse_slot(Construct &&construct) {
+        size_t index = vacant_head;
+        key_type key = vacant_slot_key(index);
+        Slot &slot = slots_pool[index];
+        key_type next = next_vacant_of(index);
+        key_type link = slot.next_vacant;
+        // the next insert reads the link of the new head, loading it now takes the cache miss off its critical path
+        if constexpr (reuse != SlabReuse::lowest) {
+            if (next != no_vacant)
+                prefetch_write(&slots_pool[next]);
+        }
+        try {
+            construct(slot, key);
+        } catch (...) {
+            // the failed constructor may have written over the link, the slot stays the head of the list
+            slot.next_vacant = link;
+            throw;
+        }
+        occupancy.set(index);
+        vacant_head = next;
+        --vacant_count;
+        count_inserts(1, 0);
+        return key;
+    }
+
+    /// Constructs the object in the vacant slot or in the new slot with construct(Slot &slot, key_type key)
+    /// and returns the key.
+    template <class Construct>
+    inline key_type emplace_slot(Construct &&construct) {
+        if (vacant_head == no_vacant)
+            return append_slot(construct);
+        return reuse_slot(construct);
+    }
+
+    /// Detaches the head slot of the vacant slots list or a new slot for the vacant entry and returns the index.
+    /// The slot is neither occupied nor linked, it stays counted as vacant until the entry is used or dropped.
+    /// Its link is no_vacant, so SlabReuse::lowest skips it.
+    /// Throws std::length_error if the number of slots would exceed max_size().
+    inline size_t reserve_slot() {
+        size_t index = vacant_head;
+        if (index != no_vacant) {
+            vacant_head = next_vacant_of(index);
+        } else {
+            index = slots_pool.size();
+            if (index >= max_size())
+                throw std::length_error("Slab keys overflow");
+
+            track_growth(index + 1, [&] {
+                slots_pool.push_back([&](Slot &slot) { init_generation(slot); }, relocator());
+            });
+            occupancy.grow(index + 1);
+            ++vacant_count;
+        }
+        slots_pool[index].next_vacant = no_vacant;
+        ++reserved_count;
+        return index;
+    }
+
+    /// Constructs the object in the slot detached by reserve_slot() and returns it.
+    template <class... Args>
+    inline T& emplace_reserved(size_t index, bool appended, Args&&... args) {
+        Slot &slot = slots_pool[index];
+        try {
+            slot.emplace(std::forward<Args>(args)...);
+        } catch (...) {
+            // restores the mark of the reserved slot, so SlabReuse::lowest still skips it
+            slot.next_vacant = no_vacant;
+            throw;
+        }
+        occupancy.set(index);
+        --vacant_count;
+        --reserved_count;
+        count_inserts(!appended, appended);
+        return slot.value;
+    }
+
+    /// Links the slot detached by reserve_slot() back to the head of the list of vacant slots, so it's reused next.
+    inline void unreserve_slot(size_t index) {
+        --reserved_count;
+        if constexpr (reuse == SlabReuse::lowest) {
+            slots_pool[index].next_vacant = 0;
+            vacant_head = std::min(vacant_head, key_type(index));
+        } else {
+            slots_pool[index].next_vacant = vacant_link(vacant_head, index);
+            if (vacant_head == no_vacant)
+                vacant_tail = key_type(index);
+            vacant_head = key_type(index);
+        }
+    }
+
+    /// Destroys the object in the occupied slot and pushes slot to the list of vacant slots by the reuse policy.
+    inline void vacate_slot(size_t index) {
+        if constexpr (reuse == SlabReuse::lifo) {
+            slots_pool[index].vacate(vacant_link(vacant_head, index));
+            occupancy.reset(index);
+            if (vacant_head == no_vacant)
+                vacant_tail = key_type(index);
+            vacant_head = key_type(index);
+            ++vacant_count;
+        } else {
+            slots_pool[index].vacate(0);
+            occupancy.reset(index);
+            push_vacant_back(index);
+        }
+        if constexpr (stats_enabled)
+            ++this->counters.removes;
+    }
+
+    /// Appends the vacant slot to the end of the list of vacant slots, so it's reused last.
+    /// With SlabReuse::lowest only moves the head to the slot if it's lower.
+    inline void push_vacant_back(size_t index) {
+        if constexpr (reuse == SlabReuse::lowest) {
+            slots_pool[index].next_vacant = 0;
+            vacant_head = std::min(vacant_head, key_type(index));
+            ++vacant_count;
+            return;
+        }
+        slots_pool[index].next_vacant = vacant_link(no_vacant, index);
+        if (vacant_head == no_vacant)
+            vacant_head = key_type(index);
+        else
+            slots_pool[vacant_tail].next_vacant = vacant_link(key_type(index), vacant_tail);
+        vacant_tail = key_type(index);
+        ++vacant_count;
+    }
+
+    /// Links all vacant slots to the list in ascending order, so lowest slots are reused first.
+    void relink_vacant_slots() {
+        vacant_head = no_vacant;
+        vacant_count = 0;
+        size_t end = slots_pool.size();
+        for (size_t i = occupancy.find_next_zero(0, end); i < end; i = occupancy.find_next_zero(i + 1, end))
+            push_vacant_back(i);
+    }
+
+    /// Moves the object from the occupied slot to the vacant slot, as if it was inserted and removed,
+    /// so with generations both slots get new generations. The source slot isn't linked to the list.
+    /// Calls on_move(old_key, new_key).
+    template <class OnMove>
+    void move_slot(size_t from, size_t to, OnMove &on_move) {
+        key_type old_key = slot_key(from);
+        slots_pool[to].emplace(std::move_if_noexcept(slots_pool[from].value));
+        occupancy.set(to);
+        slots_pool[from].vacate(no_vacant);
+        occupancy.reset(from);
+        on_move(old_key, slot_key(to));
+    }
+
+    /// Swaps all slots and objects with other slab, allocators must be equal or propagate on swap.
+    void swap_storage(Slab &other) noexcept {
+        slots_pool.swap(other.slots_pool);
+        occupancy.swap(other.occupancy);
+        std::swap(vacant_head, other.vacant_head);
+        std::swap(vacant_tail, other.vacant_tail);
+        std::swap(vacant_count, other.vacant_count);
+        std::swap(reserved_count, other.reserved_count);
+        std::swap(generation_floor, other.generation_floor);
+    }
+
+    /// Copies (or moves if other is rvalue) all slots of other slab to this empty slab.
+    template <class Other>
+    /// The occupancy bitmap is taken only after all slots are built, so if copying an object throws,
+    /// built objects are destroyed and this slab stays empty.
+    void construct_slots_from(Other &&other) {
+        using Source = std::conditional_t<std::is_lvalue_reference_v<Other>, const Slot&, Slot&&>;
+        Bitmap copied(other.occupancy, typename Bitmap::allocator_type(slots_pool.get_allocator()));
+        slots_pool.reserve(other.slots_pool.size(), relocator());
+        try {
+            for (size_t i = 0; i < other.slots_pool.size(); ++i) {
+                bool occupied = other.occupancy.test(i);
+                slots_pool.push_back([&](Slot &slot) { slot.construct_from(static_cast<Source>(other.slots_pool[i]), occupied); }, relocator());
+            }
+        } catch (...) {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (size_t i = 0; i < slots_pool.size(); ++i) {
+                    if (copied.test(i))
+                        slots_pool[i].value.~T();
+                }
+            }
+            slots_pool.truncate(0);
+            throw;
+        }
+
+        occupancy.swap(copied);
+        vacant_head = other.vacant_head;
+        vacant_tail = other.vacant_tail;
+        vacant_count = other.vacant_count;
+        reserved_count = other.reserved_count;
+        generation_floor = other.generation_floor;
+    }
+
+    /// Number of slots in one chunk of parallel iteration, 64 words of the occupancy bitmap.
+    static constexpr size_t parallel_chunk = 4096;
+
+    /// Returns the number of worker threads for the specified number of chunks,
+    /// zero threads_num means std::thread::hardware_concurrency().
+    static size_t workers_num(size_t threads_num, size_t chunks) {
+        if (threads_num == 0)
+            threads_num = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return std::max<size_t>(1, std::min(threads_num, chunks));
+    }
+
+    /// Calls visit(first_slot, last_slot, worker) for chunks of slots from workers_num threads,
+    /// the calling thread is the worker 0. Chunks are taken dynamically, so sparse chunks don't stall workers.
+    /// The first exception stops taking chunks and is rethrown after all threads are joined.
+    template <class Visit>
+    void run_chunks(size_t workers, Visit &visit) {
+        size_t slots = slots_pool.size();
+        size_t chunks = (slots + parallel_chunk - 1) / parallel_chunk;
+        if (workers <= 1) {
+            if (slots != 0)
+                visit(0, slots, 0);
+            return;
+        }
+
+        std::atomic<size_t> next_chunk { 0 };
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto work = [&](size_t worker) {
+            try {
+                for (size_t chunk = next_chunk++; chunk < chunks; chunk = next_chunk++)
+                    visit(chunk * parallel_chunk, std::min(slots, (chunk + 1) * parallel_chunk), worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+                next_chunk = chunks;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        try {
+            for (size_t worker = 1; worker < workers; ++worker)
+                threads.emplace_back(work, worker);
+        } catch (...) {
+            next_chunk = chunks;
+            for (auto &thread : threads)
+                thread.join();
+            throw;
+        }
+        work(0);
+        for (auto &thread : threads)
+            thread.join();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    /// Calls f(key, object) if f accepts the key, otherwise f(object).
+    template <class F>
+    inline decltype(auto) visit_slot(F &f, size_t index) {
+        if constexpr (std::is_invocable_v<F&, key_type, T&>)
+            return f(slot_key(index), slots_pool[index].value);
+        else
+            return f(slots_pool[index].value);
+    }
+
+    /// Arithmetic objects are scanned by vectorized kernels, 64 slots per block.
+    static constexpr bool vectorizable = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+    using Kernels = slab_detail::ArithmeticKernels<T, sizeof(Slot), Slot::value_offset>;
+
+    /// Number of slots stored contiguously: all slots of the contiguous pool or one page.
+    static constexpr size_t run_slots = paged ? Traits::page_size : std::numeric_limits<size_t>::max();
+
+    /// Scans occupied slots in order of keys. For vectorizable objects calls blocks(slots, words, blocks_num, first_slot)
+    /// for runs of whole blocks of 64 slots stored contiguously, and single(index) for remaining occupied slots.
+    /// Both return true to stop scanning.
+    template <class Blocks, class Single>
+    void scan_slots(Blocks &&blocks, Single &&single) const {
+        size_t slots = slots_pool.size();
+        for (size_t first = 0; first < slots;) {
+            size_t last = slots - first > run_slots ? first + run_slots : slots;
+            size_t blocks_num = 0;
+            if constexpr (vectorizable && run_slots >= 64) {
+                blocks_num = (last - first) / 64;
+                if (blocks_num && blocks(reinterpret_cast<const char*>(&slots_pool[first]), occupancy.data() + first / 64, blocks_num, first))
+                    return;
+            }
+            for (size_t i = occupancy.find_next(first + blocks_num * 64, last); i < last; i = occupancy.find_next(i + 1, last)) {
+                if (single(i))
+                    return;
+            }
+            first = last;
+        }
+    }
+
+    /// Returns the minimum (Max is false) or the maximum of objects.
+    template <bool Max>
+    std::optional<T> extremum() const {
+        size_t first = occupancy.find_next(0, slots_pool.size());
+        if (first == slots_pool.size())
+            return std::nullopt;
+
+        T res = slots_pool[first].value;
+        auto blocks = [&](const char *slots, const uint64_t *words, size_t blocks_num, auto) {
+            res = Kernels::template extremum<Max>(slots, words, blocks_num, res);
+            return false;
+        };
+        auto single = [&](size_t i) {
+            const T &val = slots_pool[i].value;
+            if (Max ? res < val : val < res)
+                res = val;
+            return false;
+        };
+        scan_slots(blocks, single);
+        return res;
+    }
 
 public:
     /// Constructs a new empty slab container with zero capacity.
     constexpr Slab() {}
 
+    /// Constructs a new empty slab container with zero capacity using the allocator.
+    constexpr explicit Slab(const Allocator &alloc)
+        : slots_pool(SlotAllocator(alloc))
+        , occupancy(typename Bitmap::allocator_type(alloc)) {
+    }
+
     /// Constructs a new slab container with specified reserved capacity.
-    /// For stack of removed elements will set as capacity / 2.
-    constexpr explicit Slab(size_t start_capacity) {
-        slots_pool.reserve(start_capacity);
-        stack_of_removed.reserve(start_capacity / 2);
+    constexpr explicit Slab(size_t start_capacity, const Allocator &alloc = Allocator())
+        : Slab(alloc) {
+        slots_pool.reserve(start_capacity, relocator());
+        occupancy.reserve(start_capacity);
     }
 
     /// Constructs a new slab container with values from initializer_list.
     /// Usually not needed when using slab, since constructor can't return keys.
-    constexpr Slab(std::initializer_list<T> init) {
-        slots_pool.reserve(init.size());
+    constexpr Slab(std::initializer_list<T> init, const Allocator &alloc = Allocator())
+        : Slab(alloc) {
+        if (init.size() > max_size())
+            throw std::length_error("Slab keys overflow");
+
+        slots_pool.reserve(init.size(), relocator());
         for (const T &val : init) {
-            slots_pool.push_back(val);
+            slots_pool.push_back([&](Slot &slot) { slot.emplace(val); }, relocator());
         }
+        occupancy.grow(slots_pool.size());
+        for (size_t key = 0; key < slots_pool.size(); ++key)
+            occupancy.set(key);
     }
 
-    /// Inserts a object and return the key of it in the slab.
-    /// It should be noted that after you remove element from slab, key will be reused for new elements.
-    /// Сomplexity O(1), but if not enough capacity will relocating memory and copying all elements same logic as std::vector in no capacity case.
-    constexpr size_t insert(T &&obj) {
-        size_t key = 0;
-        if (stack_of_removed.empty()) {
-            slots_pool.emplace_back(std::move(obj));
-            key = slots_pool.size() - 1;
+    Slab(const Slab &other)
+        : Slab(other, AllocTraits::select_on_container_copy_construction(other.get_allocator())) {
+    }
+
+    Slab(const Slab &other, const Allocator &alloc)
+        : Slab(alloc) {
+        construct_slots_from(other);
+    }
+
+    Slab(Slab &&other) noexcept
+        : slots_pool(std::move(other.slots_pool))
+        , occupancy(std::move(other.occupancy))
+        , vacant_head(std::exchange(other.vacant_head, no_vacant))
+        , vacant_tail(std::exchange(other.vacant_tail, no_vacant))
+        , vacant_count(std::exchange(other.vacant_count, 0))
+        , reserved_count(std::exchange(other.reserved_count, 0))
+        , generation_floor(std::exchange(other.generation_floor, 0)) {
+    }
+
+    /// Takes the memory of other slab if the allocators are equal,
+    /// otherwise moves objects one by one to the memory of the allocator.
+    Slab(Slab &&other, const Allocator &alloc)
+        : Slab(alloc) {
+        if (alloc == other.get_allocator()) {
+            swap_storage(other);
         } else {
-            key = stack_of_removed.back();
-            slots_pool[key].emplace(std::move(obj));
-            stack_of_removed.pop_back();
+            construct_slots_from(std::move(other));
         }
+    }
 
-        return key;
+    Slab& operator=(const Slab &other) {
+        if (this != &other) {
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value)
+                *this = Slab(other, other.get_allocator());
+            else
+                *this = Slab(other, get_allocator());
+        }
+        return *this;
+    }
+
+    /// Takes the memory of other slab if the allocator propagates or the allocators are equal,
+    /// otherwise moves objects one by one to the memory of own allocator.
+    /// Propagated allocator is move assigned, own objects and memory are freed with the old allocator.
+    Slab& operator=(Slab &&other) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                           || AllocTraits::is_always_equal::value) {
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            if (this != &other) {
+                destroy_objects();
+                slots_pool.move_assign(other.slots_pool);
+                occupancy = std::move(other.occupancy);
+                vacant_head = std::exchange(other.vacant_head, no_vacant);
+                vacant_tail = std::exchange(other.vacant_tail, no_vacant);
+                vacant_count = std::exchange(other.vacant_count, 0);
+                reserved_count = std::exchange(other.reserved_count, 0);
+                generation_floor = std::exchange(other.generation_floor, 0);
+            }
+        } else if constexpr (AllocTraits::is_always_equal::value) {
+            swap_storage(other);
+        } else if (get_allocator() == other.get_allocator()) {
+            swap_storage(other);
+        } else {
+            Slab moved(std::move(other), get_allocator());
+            swap_storage(moved);
+        }
+        return *this;
+    }
+
+    ~Slab() {
+        destroy_objects();
+    }
+
+    /// Inserts a object and return the key of it in the slab.
+    /// It should be noted that after you remove element from slab, key will be reused for new elements.
+    /// Сomplexity O(1), but if not enough capacity will relocating memory and copying all elements same logic as std::vector in no capacity case.
+    /// Throws std::length_error if the number of slots would exceed max_size().
+    constexpr key_type insert(T &&obj) {
+        return emplace_slot([&](Slot &slot, key_type) { slot.emplace(std::move(obj)); });
     }
 
     /// Inserts a object and return the key of it in slab.
     /// It should be noted that after you remove element from slab, key will be reused for new elements.
     /// Сomplexity O(1), but if not enough capacity will relocating memory and copying all elements same logic as std::vector in no capacity case.
-    constexpr size_t insert(T &obj) {
-        size_t key = 0;
-        if (stack_of_removed.empty()) {
-            slots_pool.emplace_back(obj);
-            key = slots_pool.size() - 1;
+    /// Throws std::length_error if the number of slots would exceed max_size().
+    constexpr key_type insert(T &obj) {
+        return emplace_slot([&](Slot &slot, key_type) { slot.emplace(obj); });
+    }
+
+    /// Constructs a object in place from the arguments and return the key of it in the slab.
+    /// The object is constructed directly in the reused or new slot without temporary objects.
+    /// Сomplexity O(1), but if not enough capacity will relocating memory and moving all elements same logic as std::vector in no capacity case.
+    /// Throws std::length_error if the number of slots would exceed max_size().
+    template <class... Args>
+    inline key_type emplace(Args&&... args) {
+        return emplace_slot([&](Slot &slot, key_type) { slot.emplace(std::forward<Args>(args)...); });
+    }
+
+    /// Constructs a object in place with the future key of it as the first argument
+    /// followed by the arguments and return the key.
+    /// So the object knows own key without calling vacant_key() before inserting.
+    /// Сomplexity O(1), but if not enough capacity will relocating memory and moving all elements same logic as std::vector in no capacity case.
+    /// Throws std::length_error if the number of slots would exceed max_size().
+    template <class... Args>
+    inline key_type emplace_with_key(Args&&... args) {
+        return emplace_slot([&](Slot &slot, key_type key) { slot.emplace(key, std::forward<Args>(args)...); });
+    }
+
+    /// Vacant slot reserved by reserve() with the key the object constructed in it will have.
+    /// emplace() constructs the object in the slot without looking for a vacant slot again.
+    /// If the entry is dropped without emplace(), the slot returns to the slab and is reused next.
+    /// The entry refers to the slab, so it must be used or dropped before the slab is moved, copied, cleared,
+    /// compacted or trimmed. Other objects may be inserted and removed meanwhile, they never take the reserved slot.
+    class VacantEntry {
+        Slab *slab;
+        size_t index;
+        key_type entry_key;
+        bool appended;
+
+        VacantEntry(Slab &slab, size_t index, bool appended)
+            : slab(&slab), index(index), entry_key(slab.vacant_slot_key(index)), appended(appended) {}
+
+        friend Slab;
+
+    public:
+        VacantEntry(VacantEntry &&other) noexcept
+            : slab(std::exchange(other.slab, nullptr))
+            , index(other.index)
+            , entry_key(other.entry_key)
+            , appended(other.appended) {}
+
+        VacantEntry& operator=(const VacantEntry &) = delete;
+
+        ~VacantEntry() {
+            if (slab)
+                slab->unreserve_slot(index);
+        }
+
+        /// Returns the key of the object that will be constructed in the slot.
+        inline key_type key() const {
+            return entry_key;
+        }
+
+        /// Constructs the object in the reserved slot from the arguments and returns a reference to it.
+        /// The entry becomes empty and must not be used again. If the constructor throws, the slot stays reserved.
+        /// Сomplexity O(1).
+        template <class... Args>
+        inline T& emplace(Args&&... args) {
+            T &obj = slab->emplace_reserved(index, appended, std::forward<Args>(args)...);
+            slab = nullptr;
+            return obj;
+        }
+
+        /// Moves the object to the reserved slot and returns a reference to it.
+        /// Сomplexity O(1).
+        inline T& insert(T &&obj) {
+            return emplace(std::move(obj));
+        }
+    };
+
+    /// Reserves a vacant slot (same as vacant_key() would return) and returns the entry holding it,
+    /// so the object can get own key before it's constructed, for example to register callbacks:
+    ///   auto entry = slab.reserve();
+    ///   entry.emplace(entry.key(), reactor);
+    /// Сomplexity O(1), but if not enough capacity will relocating memory same as insert().
+    /// Throws std::length_error if the number of slots would exceed max_size().
+    inline VacantEntry reserve() {
+        bool appended = vacant_head == no_vacant;
+        size_t index = reserve_slot();
+        return VacantEntry(*this, index, appended);
+    }
+
+    /// Inserts objects from the range [first, last) and writes their keys to out_keys.
+    /// Returns output iterator past the last written key.
+    /// Vacant slots are reused in one pass, then for forward iterators the pool grows once
+    /// and the remaining objects are appended contiguously.
+    /// The range must not refer to objects of this slab.
+    /// If construction of an object throws, objects inserted before it stay in the slab and their keys are written.
+    /// Throws std::length_error if the number of slots would exceed max_size().
+    template <class InputIt, class OutputIt>
+    OutputIt insert_range(InputIt first, InputIt last, OutputIt out_keys) {
+        for (; first != last && vacant_head != no_vacant; ++first, ++out_keys)
+            *out_keys = reuse_slot([&](Slot &slot, key_type) { slot.emplace(*first); });
+
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+            size_t from = slots_pool.size();
+            size_t required = from + size_t(std::distance(first, last));
+            if (required > max_size())
+                throw std::length_error("Slab keys overflow");
+
+            if (required > slots_pool.capacity()) {
+                track_growth(required, [&] {
+                    slots_pool.reserve(std::max(required, slots_pool.capacity() * 2), relocator());
+                });
+            }
+
+            // bits are set as objects are constructed, so if construction throws appended objects stay in the slab
+            occupancy.grow(required);
+            for (; first != last; ++first, ++out_keys) {
+                size_t index = slots_pool.size();
+                key_type key = vacant_slot_key(index);
+                slots_pool.push_back([&](Slot &slot) { init_generation(slot); slot.emplace(*first); }, relocator());
+                occupancy.set(index);
+                count_inserts(0, 1);
+                *out_keys = key;
+            }
         } else {
-            key = stack_of_removed.back();
-            slots_pool[key].emplace(obj);
-            stack_of_removed.pop_back();
+            for (; first != last; ++first, ++out_keys)
+                *out_keys = append_slot([&](Slot &slot, key_type) { slot.emplace(*first); });
         }
-        return key;
+
+        return out_keys;
+    }
+
+    /// Removes objects by the keys from the range [first, last).
+    /// Returns the number of removed objects, keys of not existing objects are skipped.
+    /// Never allocates.
+    /// Сomplexity O(n).
+    template <class InputIt>
+    size_t remove_keys(InputIt first, InputIt last) {
+        size_t removed = 0;
+        for (; first != last; ++first) {
+            key_type key = *first;
+            if (contains(key)) {
+                vacate_slot(key_index(key));
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+    /// Moves objects from the highest slots to the lowest vacant slots, so all objects occupy slots [0, size()).
+    /// Calls on_move(old_key, new_key) for every moved object to patch references to it.
+    /// Without generations trailing vacant slots are dropped, so iteration and vacant_key() don't see them,
+    /// memory is kept (see shrink_to_fit()). With generations trailing slots keep generations
+    /// to reject stale keys and are linked to the list of vacant slots in ascending order.
+    /// Returns the number of moved objects.
+    /// Сomplexity O(n) where n is the number of slots.
+    template <class OnMove>
+    size_t compact(OnMove &&on_move) {
+        size_t moved = 0;
+        size_t low = 0;
+        size_t high = slots_pool.size();
+        try {
+            for (;;) {
+                low = occupancy.find_next_zero(low, slots_pool.size());
+                high = occupancy.find_prev(high);
+                if (high == Bitmap::npos || low >= high)
+                    break;
+
+                move_slot(high, low, on_move);
+                ++moved;
+            }
+        } catch (...) {
+            relink_vacant_slots();
+            throw;
+        }
+
+        if constexpr (generational) {
+            relink_vacant_slots();
+        } else {
+            slots_pool.truncate(size());
+            vacant_head = no_vacant;
+            vacant_count = 0;
+        }
+        return moved;
+    }
+
+    /// Incremental compact(), moves at most max_moves objects from the highest slots
+    /// to the vacant slots from the head of the list, so latency of one call is bounded.
+    /// Vacated slots and vacant slots above the highest object are appended to the end of the list,
+    /// slots are not dropped. Inserting and removing between calls is allowed.
+    /// Calls on_move(old_key, new_key) for every moved object.
+    /// Returns true if compaction is finished: no vacant slot is below the highest object.
+    /// Every step either moves an object or moves a vacant slot above the highest object to the end of the list.
+    /// Сomplexity O(max_moves) plus skipping vacant slots above the highest object by 64 per step.
+    template <class OnMove>
+    bool compact_step(size_t max_moves, OnMove &&on_move) {
+        size_t high = occupancy.find_prev(slots_pool.size());
+        for (size_t steps = 0; steps < max_moves; ++steps) {
+            // objects occupy all slots up to the highest one
+            if (high == Bitmap::npos || high + 1 == size())
+                return true;
+
+            size_t target = vacant_head;
+            vacant_head = next_vacant_of(target);
+            --vacant_count;
+            if (target > high) {
+                push_vacant_back(target);
+                continue;
+            }
+
+            try {
+                move_slot(high, target, on_move);
+            } catch (...) {
+                push_vacant_back(target);
+                throw;
+            }
+            push_vacant_back(high);
+            high = occupancy.find_prev(high);
+        }
+        return high == Bitmap::npos || high + 1 == size();
+    }
+
+    /// Drops trailing vacant slots and links remaining vacant slots in ascending order, so lowest slots are reused first.
+    /// With paged storage frees pages after the last object and returns memory of empty pages to the OS
+    /// with madvise(MADV_DONTNEED), except with generations since vacant slots keep generations.
+    /// Objects are not relocated. With generations new slots continue generations of dropped ones.
+    /// Returns the number of dropped slots.
+    /// Сomplexity O(n) where n is the number of slots.
+    size_t trim() {
+        size_t last = occupancy.find_prev(slots_pool.size());
+        size_t end = last == Bitmap::npos ? 0 : last + 1;
+        size_t dropped = slots_pool.size() - end;
+        if constexpr (generational) {
+            for (size_t i = end; i < slots_pool.size(); ++i)
+                generation_floor = std::max(generation_floor, slots_pool[i].generation);
+        }
+
+        slots_pool.truncate(end);
+        relink_vacant_slots();
+        if constexpr (paged) {
+            slots_pool.shrink_to_fit(relocator());
+            if constexpr (!generational) {
+                for (size_t first = 0; first + Traits::page_size <= end; first += Traits::page_size) {
+                    if (occupancy.none(first, first + Traits::page_size))
+                        slots_pool.release_page(first / Traits::page_size);
+                }
+            }
+        }
+        return dropped;
+    }
+
+    /// Same as trim() and also frees unused capacity of slots and of the occupancy bitmap.
+    /// Contiguous storage is reallocated to fit slots, so references to objects are invalidated.
+    /// Returns the number of dropped slots.
+    /// Сomplexity O(n) where n is the number of slots.
+    size_t shrink_to_fit() {
+        size_t dropped = trim();
+        size_t old_capacity = slots_pool.capacity();
+        slots_pool.shrink_to_fit(relocator());
+        if (slots_pool.capacity() != old_capacity)
+            count_reallocation(slots_pool.size() * sizeof(Slot));
+        occupancy.shrink_to_fit(slots_pool.size());
+        return dropped;
+    }
+
+    /// Returns the number of slots, occupied and vacant. Slots are indexed in [0, slots_count()).
+    inline size_t slots_count() const {
+        return slots_pool.size();
+    }
+
+private:
+    /// Returns the end of the run of occupied slots stored contiguously starting at the slot by the index.
+    inline size_t run_end(size_t first) const {
+        size_t last = slots_pool.size();
+        if constexpr (paged)
+            last = std::min(last, (first / Traits::page_size + 1) * Traits::page_size);
+        return occupancy.find_next_zero(first, last);
+    }
+
+public:
+    /// Objects are stored as a plain array of T: slots have no generations and the size of T.
+    static constexpr bool packed_runs = !generational && sizeof(Slot) == sizeof(T);
+
+    /// Maximal run of occupied slots stored contiguously, so a loop over it has no vacancy checks.
+    /// If packed_runs, objects are a plain array and begin() and data() are T*,
+    /// otherwise begin() is a random access iterator stepping over whole slots.
+    /// Runs don't cross pages of paged storage.
+    class Run {
+        Slot *slots;
+        size_t first_index;
+        size_t count;
+
+        Run(Slot *slots, size_t first_index, size_t count)
+            : slots(slots), first_index(first_index), count(count) {}
+
+        friend Slab;
+
+    public:
+        using iterator = std::conditional_t<packed_runs, T*, slab_detail::StridedIterator<T, sizeof(Slot)>>;
+
+        /// Returns the key of the i-th object of the run.
+        inline key_type key(size_t i) const {
+            if constexpr (generational)
+                return key_type((first_index + i) | (size_t(slots[i].generation) << index_bits));
+            else
+                return key_type(first_index + i);
+        }
+
+        /// Returns the key of the first object, without generations keys of following objects are consecutive.
+        inline key_type first_key() const {
+            return key(0);
+        }
+
+        inline size_t size() const {
+            return count;
+        }
+
+        inline T& operator[](size_t i) const {
+            return slots[i].value;
+        }
+
+        inline iterator begin() const {
+            return iterator(&slots->value);
+        }
+
+        inline iterator end() const {
+            return begin() + std::ptrdiff_t(count);
+        }
+
+        /// Returns the pointer to the array of objects, only if packed_runs.
+        inline T* data() const {
+            static_assert(packed_runs, "Objects of runs are not a plain array, use begin() and end().");
+            return &slots->value;
+        }
+    };
+
+    /// Forward iterator over runs of occupied slots in order of keys.
+    class RunIterator {
+        Slab *slab;
+        /// Current run [first, last), first is the number of slots at the end.
+        size_t first;
+        size_t last;
+
+        RunIterator(Slab &slab, size_t from)
+            : slab(&slab), first(slab.occupancy.find_next(from, slab.slots_pool.size())), last(slab.run_end(first)) {}
+
+        friend Slab;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = Run;
+        using pointer           = void;
+        using reference         = Run;
+
+        inline Run operator*() const {
+            return Run(&slab->slots_pool[first], first, last - first);
+        }
+
+        inline RunIterator& operator++() {
+            first = slab->occupancy.find_next(last, slab->slots_pool.size());
+            last = slab->run_end(first);
+            return *this;
+        }
+
+        inline RunIterator operator++(int) {
+            RunIterator res = *this;
+            ++*this;
+            return res;
+        }
+
+        friend inline bool operator==(const RunIterator &a, const RunIterator &b) {
+            return a.first == b.first;
+        }
+
+        friend inline bool operator!=(const RunIterator &a, const RunIterator &b) {
+            return a.first != b.first;
+        }
+    };
+
+    /// Range of runs returned by runs().
+    struct Runs {
+        RunIterator first;
+        RunIterator last;
+
+        inline RunIterator begin() const { return first; }
+        inline RunIterator end() const { return last; }
+    };
+
+    /// Returns the range of maximal runs of occupied slots in order of keys:
+    ///   for (auto run : slab.runs())
+    ///       for (T &obj : run) ...
+    /// Vacant slots are skipped once per run with the occupancy bitmap, 64 slots per step,
+    /// and the inner loop over a run is a plain loop that compilers vectorize.
+    inline Runs runs() {
+        return Runs { RunIterator(*this, 0), RunIterator(*this, slots_pool.size()) };
+    }
+
+    /// Calls f(first_key, run) for every maximal run of occupied slots in order of keys, see runs() and Run.
+    template <class F>
+    void for_each_run(F &&f) {
+        for (Run run : runs())
+            f(run.first_key(), run);
+    }
+
+    /// Calls f(object) or f(key, object) for objects in slots [first_slot, last_slot) in order of keys.
+    /// Vacant slots are skipped with the occupancy bitmap, 64 slots per step.
+    /// Splittable by slots, so ranges of slots can be processed by any thread pool or std::execution::par.
+    template <class F>
+    void for_each_in(size_t first_slot, size_t last_slot, F &&f) {
+        last_slot = std::min(last_slot, slots_pool.size());
+        for (size_t i = occupancy.find_next(first_slot, last_slot); i < last_slot; i = occupancy.find_next(i + 1, last_slot))
+            visit_slot(f, i);
+    }
+
+    /// Calls f(object) or f(key, object) for all objects from threads_num threads,
+    /// zero means std::thread::hardware_concurrency(). The calling thread is one of them.
+    /// Slots are divided to chunks of parallel_chunk slots taken by threads dynamically.
+    /// f is called concurrently for different objects, the slab must not be modified meanwhile.
+    /// The first exception thrown by f is rethrown after all threads finish.
+    template <class F>
+    void parallel_for_each(F &&f, size_t threads_num = 0) {
+        size_t workers = workers_num(threads_num, (slots_pool.size() + parallel_chunk - 1) / parallel_chunk);
+        auto visit = [&](size_t first, size_t last, size_t) { for_each_in(first, last, f); };
+        run_chunks(workers, visit);
+    }
+
+    /// Returns init combined by reduce(R, R) with transform(object) or transform(key, object) of all objects,
+    /// calculated from threads_num threads, zero means std::thread::hardware_concurrency().
+    /// reduce must be associative and commutative, since order of combining is unspecified.
+    /// transform is called concurrently for different objects, the slab must not be modified meanwhile.
+    template <class R, class Reduce, class Transform>
+    R parallel_reduce(R init, Reduce reduce, Transform transform, size_t threads_num = 0) {
+        size_t workers = workers_num(threads_num, (slots_pool.size() + parallel_chunk - 1) / parallel_chunk);
+        // aligned to avoid false sharing between threads
+        struct alignas(64) Partial {
+            std::optional<R> value;
+        };
+        std::vector<Partial> partials(workers);
+
+        auto visit = [&](size_t first, size_t last, size_t worker) {
+            std::optional<R> acc;
+            for (size_t i = occupancy.find_next(first, last); i < last; i = occupancy.find_next(i + 1, last)) {
+                if (acc)
+                    acc = reduce(std::move(*acc), visit_slot(transform, i));
+                else
+                    acc.emplace(visit_slot(transform, i));
+            }
+            if (acc) {
+                std::optional<R> &partial = partials[worker].value;
+                partial = partial ? reduce(std::move(*partial), std::move(*acc)) : std::move(*acc);
+            }
+        };
+        run_chunks(workers, visit);
+
+        for (Partial &partial : partials) {
+            if (partial.value)
+                init = reduce(std::move(init), std::move(*partial.value));
+        }
+        return init;
+    }
+
+    /// Returns the number of objects equal to the value.
+    /// Arithmetic objects are compared 64 slots per step with SIMD instructions, see find().
+    /// Сomplexity O(n) where n is the number of slots.
+    size_t count(const T &value) const {
+        size_t res = 0;
+        auto blocks = [&](const char *slots, const uint64_t *words, size_t blocks_num, auto) {
+            res += Kernels::count(slots, words, blocks_num, value);
+            return false;
+        };
+        auto single = [&](size_t i) {
+            res += slots_pool[i].value == value;
+            return false;
+        };
+        scan_slots(blocks, single);
+        return res;
+    }
+
+    /// Returns the smallest object or std::nullopt if the slab is empty.
+    /// Arithmetic objects are compared 64 slots per step with SIMD instructions, see find().
+    /// Floating point NaN objects are skipped unless the first object is NaN.
+    /// Сomplexity O(n) where n is the number of slots.
+    inline std::optional<T> min() const {
+        return extremum<false>();
+    }
+
+    /// Returns the largest object or std::nullopt if the slab is empty.
+    /// Arithmetic objects are compared 64 slots per step with SIMD instructions, see find().
+    /// Floating point NaN objects are skipped unless the first object is NaN.
+    /// Сomplexity O(n) where n is the number of slots.
+    inline std::optional<T> max() const {
+        return extremum<true>();
+    }
+
+    /// Returns the sum of all objects calculated in type T, T() if the slab is empty.
+    /// Arithmetic objects are added 64 slots per step with SIMD instructions, see find(),
+    /// so floating point objects are added in unspecified order.
+    /// Сomplexity O(n) where n is the number of slots.
+    T sum() const {
+        T res = T();
+        auto blocks = [&](const char *slots, const uint64_t *words, size_t blocks_num, auto) {
+            res += Kernels::sum(slots, words, blocks_num);
+            return false;
+        };
+        auto single = [&](size_t i) {
+            res += slots_pool[i].value;
+            return false;
+        };
+        scan_slots(blocks, single);
+        return res;
     }
 
     /// Returns true if the object by the key exist or false if it doesn't.
-    inline bool contains(size_t key) {
-        return key < slots_pool.size() && slots_pool[key] != std::nullopt;
+    /// Checks only the occupancy bitmap without touching the slot.
+    /// With generations checks the generation stored in the slot next to the object,
+    /// so a stale key of a removed object is rejected even if the slot is reused.
+    /// Generations of occupied slots are odd, so a key with even generation of a vacant slot is rejected too.
+    inline bool contains(key_type key) const {
+        size_t index = key_index(key);
+        if (index >= slots_pool.size())
+            return false;
+
+        if constexpr (generational)
+            return ((key >> index_bits) & 1) && slot_key(index) == key;
+        else
+            return occupancy.test(index);
+    }
+
+    /// Returns a pointer to the object in the slab by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    inline T* try_get(key_type key) {
+        return contains(key) ? &slots_pool[key_index(key)].value : nullptr;
+    }
+
+    /// Returns a const pointer to the object in the slab by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    inline const T* try_get(key_type key) const {
+        return contains(key) ? &slots_pool[key_index(key)].value : nullptr;
     }
 
     /// Returns a reference to the object in the slab by the key.
@@ -80,8 +2261,8 @@ public:
     /// If the object by key doesn't exist then undefined behavior.
     /// To check for the existence use contains().
     /// Сomplexity O(1).
-    inline T& get(size_t key) {
-        return *slots_pool[key];
+    inline T& get(key_type key) {
+        return slots_pool[key_index(key)].value;
     }
 
     /// Returns a const reference to the object in the slab by the key.
@@ -89,52 +2270,46 @@ public:
     /// If the object by key doesn't exist then undefined behavior.
     /// To check for the existence use contains().
     /// Сomplexity O(1).
-    inline const T& get(size_t key) const {
-        return *slots_pool[key];
+    inline const T& get(key_type key) const {
+        return slots_pool[key_index(key)].value;
     }
 
     /// Removes object from the slab by the key.
     /// Returns false if obect by key not exist.
+    /// Never allocates, the slot itself becomes a node of the list of vacant slots.
     /// Сomplexity O(1).
-    bool remove(size_t key) {
-        if (key >= slots_pool.size())
+    bool remove(key_type key) {
+        if (!contains(key))
             return false;
 
-        auto &obj = slots_pool[key];
-        if (slots_pool[key] == std::nullopt)
-            return false;
-
-        obj = std::nullopt;
-        stack_of_removed.push_back(key);
-
+        vacate_slot(key_index(key));
         return true;
     }
 
     /// Returns determined the slab key what will assigned for next added object.
     /// Сomplexity O(1).
-    inline size_t vacant_key() const {
-        return stack_of_removed.empty() ? slots_pool.size() : stack_of_removed.back();
+    inline key_type vacant_key() const {
+        return vacant_slot_key(vacant_head == no_vacant ? slots_pool.size() : vacant_head);
     }
 
     /// Move object from the slab by the key.
     /// Returns moved stored object or std::nullopt if obect by key not exist.
     /// Сomplexity O(1).
-    inline std::optional<T> take(size_t key) {
+    inline std::optional<T> take(key_type key) {
         std::optional<T> res = std::nullopt;
-        if (key >= slots_pool.size())
+        if (!contains(key))
             return res;
 
-        slots_pool[key].swap(res);
-        if (res != std::nullopt)
-            stack_of_removed.push_back(key);
-
+        size_t index = key_index(key);
+        res.emplace(std::move(slots_pool[index].value));
+        vacate_slot(index);
         return res;
     }
 
     /// Returns the number of stored objects.
     /// Сomplexity O(1).
     inline size_t size() const {
-        return slots_pool.size() - stack_of_removed.size();
+        return slots_pool.size() - vacant_count;
     }
 
     /// Returns true if there are no objects stored in the slab.
@@ -143,34 +2318,82 @@ public:
         return size() == 0;
     }
 
+    /// Returns the maximum number of slots, limited by the slot index bits of the key.
+    static constexpr size_t max_size() {
+        return index_mask;
+    }
+
     /// Returns the number of objects the slab can store without reallocating.
+    /// For paged storage it is the number of slots in allocated pages.
     inline size_t slots_capacity() const {
         return slots_pool.capacity();
     }
 
-    /// Returns the capacity of the removed objects stack.
-    inline size_t stack_capacity() const {
-        return stack_of_removed.capacity();
+    /// Returns the number of bytes allocated for slots.
+    inline size_t memory_usage() const {
+        return slots_pool.capacity() * sizeof(Slot);
+    }
+
+    /// Returns the allocator of the slab.
+    inline allocator_type get_allocator() const {
+        return allocator_type(slots_pool.get_allocator());
+    }
+
+    /// Returns the snapshot of runtime statistics. Available only if enabled by Traits::stats.
+    /// Сomplexity O(n / 64) where n is the number of slots, for finding the longest vacant run in the bitmap.
+    SlabStats stats() const {
+        static_assert(stats_enabled, "Statistics are disabled by Traits::stats.");
+        SlabStats res = this->counters;
+        res.inserts = res.reused_slots + res.appended_slots;
+        res.fragmentation = slots_pool.size() ? double(vacant_count) / double(slots_pool.size()) : 0.0;
+        res.longest_vacant_run = longest_vacant_run();
+        return res;
+    }
+
+    /// Resets counters of statistics, the high-water mark starts from the current size.
+    /// Available only if enabled by Traits::stats.
+    void reset_stats() {
+        static_assert(stats_enabled, "Statistics are disabled by Traits::stats.");
+        this->counters = SlabStats();
+        this->counters.high_water_mark = size();
+    }
+
+    /// Sets the function called with SlabGrowth after every growth of the storage by inserting,
+    /// so long reallocations can be exported as metrics. Empty function removes the hook.
+    /// Available only if enabled by Traits::stats.
+    void set_growth_hook(std::function<void(const SlabGrowth &)> hook) {
+        static_assert(stats_enabled, "Statistics are disabled by Traits::stats.");
+        this->growth_hook = std::move(hook);
     }
 
     /// Slab iterator.
     ///
     /// Iterator is bidirectional.
     /// Allows use it with standard algorithms.
-    /// It should be noted that iteration from one elements to another
-    /// may include iterations of skipping removed objects slots.
-    /// Usually even if there are many removed elements in the slab,
-    /// iterations is fast, like a iterations of the std::vector.
+    /// Removed objects slots are skipped with the occupancy bitmap,
+    /// 64 slots per step, so iteration cost depends on the number of stored objects
+    /// rather than on the number of slots.
+    /// The iterator keeps the not visited bits of the current bitmap word and takes the next object
+    /// from them with ctz, the bitmap is read again only when the word is used up.
+    /// So objects of the current word removed after the iterator reached the word are still visited.
     class Iterator
     {
-        Iterator(Slab<T> &slab, size_t p) : slab(slab), pos(p) {
-            while (pos < slab.slots_pool.size() && slab.slots_pool[pos] == std::nullopt)
-                ++pos;
+        Iterator(Slab &slab, key_type p)
+            : slab(slab)
+            , pos(key_type(slab.occupancy.find_next(p, slab.slots_pool.size())))
+            , bits(word_from(slab, pos)) {
+        }
+
+        /// Returns bits of the bitmap word of the slot at and after the slot, zero for the end.
+        static inline uint64_t word_from(const Slab &slab, size_t pos) {
+            if (pos >= slab.slots_pool.size())
+                return 0;
+            return slab.occupancy.data()[pos >> 6] & (~uint64_t(0) << (pos & 63));
         }
 
     public:
         using iterator_category = std::bidirectional_iterator_tag;
-        using difference_type   = std::size_t;
+        using difference_type   = std::ptrdiff_t;
         using value_type        = T;
         using pointer           = T*;
         using reference         = T&;
@@ -178,27 +2401,34 @@ public:
 
         inline Iterator & operator=(const Iterator &right) {
             pos = right.pos;
+            bits = right.bits;
             return *this;
         }
 
         inline reference operator*() const {
-            return *slab.slots_pool[pos];
+            return slab.slots_pool[pos].value;
         }
 
         inline pointer operator->() {
-            return &*slab.slots_pool[pos];
+            return &slab.slots_pool[pos].value;
         }
 
         inline Iterator & operator++() {
-            // skeep empty slots
-            while (++pos < slab.slots_pool.size() && slab.slots_pool[pos] == std::nullopt);
+            bits &= bits - 1;
+            if (bits != 0) {
+                pos = key_type((size_t(pos) & ~size_t(63)) + slab_detail::ctz64(bits));
+            } else {
+                size_t next = slab.occupancy.find_next((size_t(pos) | 63) + 1, slab.slots_pool.size());
+                pos = key_type(next);
+                bits = word_from(slab, next);
+            }
             return *this;
         }
 
         inline Iterator & operator--() {
-            int s = slab.slots_pool.size();
-            // skeep empty slots
-            while (--pos > 0 && slab.slots_pool[pos] == std::nullopt);
+            size_t prev = slab.occupancy.find_prev(pos);
+            pos = prev == Bitmap::npos ? 0 : key_type(prev);
+            bits = word_from(slab, pos);
             return *this;
         }
 
@@ -214,58 +2444,85 @@ public:
             return pos < other.pos;
         }
 
+        /// Returns the distance in slots, not in objects.
         inline difference_type operator-(const Iterator &right) {
-            return pos - right.pos;
+            return difference_type(pos) - difference_type(right.pos);
         }
 
         inline Iterator operator+(const int &right) {
-            return Iterator(slab, pos + right);
+            return Iterator(slab, key_type(pos + right));
         }
 
         inline Iterator operator-(const int &right) {
-            return Iterator(slab, pos - right);
+            return Iterator(slab, key_type(pos - right));
         }
 
     protected:
-        Slab<T> &slab;
-        size_t pos;
+        Slab &slab;
+        /// Index of the slot.
+        key_type pos;
+        /// Occupied slots of the bitmap word of pos at and after pos.
+        uint64_t bits;
     };
 
     /// Returns bidirectional iterator to the beginning.
     inline Iterator begin() { return Iterator(*this, 0); }
 
     /// Returns bidirectional iterator to the end (past-the-last element).
-    inline Iterator end() { return Iterator(*this, slots_pool.size()); }
+    inline Iterator end() { return Iterator(*this, key_type(slots_pool.size())); }
 
+    /// Returns the iterator to the first object equal to the value in order of keys or end().
+    /// Arithmetic objects are compared 64 slots per step with SIMD instructions (AVX2 if the CPU supports it),
+    /// vacant slots are masked by the occupancy bitmap.
+    /// Сomplexity O(n) where n is the number of slots.
+    Iterator find(const T &value) {
+        size_t found = slots_pool.size();
+        auto single = [&](size_t i) {
+            if (!(slots_pool[i].value == value))
+                return false;
+            found = i;
+            return true;
+        };
+        auto blocks = [&](const char *slots, const uint64_t *words, size_t blocks_num, auto first_slot) {
+            size_t block = Kernels::find_block(slots, words, blocks_num, value);
+            if (block == blocks_num)
+                return false;
+            size_t first = first_slot + block * 64;
+            for (size_t i = occupancy.find_next(first, first + 64); i < first + 64; i = occupancy.find_next(i + 1, first + 64)) {
+                if (single(i))
+                    break;
+            }
+            return true;
+        };
+        scan_slots(blocks, single);
+        return Iterator(*this, key_type(found));
+    }
 
     /// Slab iterator where dereferencing presented as key value pair.
     ///
     /// Iterator is forward.
     /// Allows iterate via slab collection and use only minimal set of standard algorithms.
-    /// It should be noted that iteration from one elements to another
-    /// may include iterations of skipping removed objects slots.
-    /// Usually even if there are many removed elements in the slab,
-    /// iterations is fast, like a iterations of the std::vector.
+    /// Removed objects slots are skipped with the occupancy bitmap same as in Iterator.
 
     class KeyValIterator : public Iterator {
         using iterator_category = std::forward_iterator_tag;
-        using difference_type   = std::size_t;
-        using value_type        = std::pair<size_t, T>;
-        using pointer           = std::pair<size_t, T*>;
-        using reference         = std::pair<size_t, T&>;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = std::pair<key_type, T>;
+        using pointer           = std::pair<key_type, T*>;
+        using reference         = std::pair<key_type, T&>;
         friend Slab;
 
-        KeyValIterator(Slab<T> &slab, size_t pos)
+        KeyValIterator(Slab &slab, key_type pos)
             : Iterator(slab, pos) {
         }
 
     public:
         inline reference operator*() const {
-            return std::pair<size_t, T&>(Iterator::pos, *(Iterator::slab.slots_pool[Iterator::pos]));
+            return reference(Iterator::slab.slot_key(Iterator::pos), Iterator::slab.slots_pool[Iterator::pos].value);
         }
 
         inline pointer operator->() {
-            return std::pair(Iterator::pos, &*Iterator::slab.slots_pool[Iterator::pos]);
+            return pointer(Iterator::slab.slot_key(Iterator::pos), &Iterator::slab.slots_pool[Iterator::pos].value);
         }
     };
 
@@ -275,7 +2532,7 @@ public:
 
     /// Returns forward iterator to the end (past-the-last element).
     /// Dereferencing this iterator presented as key value pair.
-    inline KeyValIterator key_val_end() { return KeyValIterator(*this, slots_pool.size()); }
+    inline KeyValIterator key_val_end() { return KeyValIterator(*this, key_type(slots_pool.size())); }
 
     /// For out all slab elements to std::ostream with custom separator.
     /// Type of elements must have operator << .
@@ -294,9 +2551,26 @@ public:
 
 /// Operator << for out to ostream all elements of slab collection.
 /// Elements separated by a space. Type of elements must have operator << .
-template <class T>
-std::ostream& operator<<(std::ostream& stream, Slab<T> &slab) {
+template <class T, class Traits, class Allocator>
+std::ostream& operator<<(std::ostream& stream, Slab<T, Traits, Allocator> &slab) {
     return slab.out(stream);
 }
 
+/// Slab with paged storage, stored objects are never relocated.
+template <class T, size_t PageSize = 1024>
+using PagedSlab = Slab<T, PagedSlabTraits<PageSize>>;
+
+/// Slab with generational keys, stale keys of removed objects are rejected.
+template <class T, unsigned GenerationBits = 32>
+using GenerationalSlab = Slab<T, GenerationalSlabTraits<GenerationBits>>;
+
+namespace pmr {
+
+/// Slab allocating memory from std::pmr::memory_resource.
+/// With std::pmr::monotonic_buffer_resource memory of the slab is released with the whole arena.
+template <class T, class Traits = SlabTraits>
+using Slab = ::Slab<T, Traits, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 #endif
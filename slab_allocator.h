@@ -0,0 +1,189 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include "slab.h"
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace slab_detail {
+
+/// Pool of blocks of one size, the base to keep pools of different sizes in one arena.
+class NodePoolBase {
+public:
+    const size_t size;
+    const size_t align;
+
+    NodePoolBase(size_t size, size_t align) : size(size), align(align) {}
+    NodePoolBase(const NodePoolBase &) = delete;
+    NodePoolBase& operator=(const NodePoolBase &) = delete;
+    virtual ~NodePoolBase() = default;
+
+    /// Returns the number of bytes of allocated pages.
+    virtual size_t memory_usage() const = 0;
+};
+
+/// Pool of blocks of Size bytes aligned to Align.
+/// Blocks are slots of the paged slot pool of the slab, so they are never relocated.
+/// Vacant blocks are linked to the stack threaded through the blocks themselves, same as vacant slots of the slab,
+/// but by pointers, since deallocation gets the pointer instead of the key.
+template <size_t Size, size_t Align, size_t PageSize>
+class NodePool : public NodePoolBase {
+    union Block {
+        alignas(Align) unsigned char bytes[Size];
+        Block *next_vacant;
+    };
+
+    PagedSlotPool<Block, PageSize> blocks;
+    /// Last deallocated block, head of the stack of vacant blocks.
+    Block *vacant_head = nullptr;
+
+public:
+    NodePool() : NodePoolBase(Size, Align) {}
+
+    /// Returns the last deallocated block or a new block.
+    /// Сomplexity O(1), allocates a page of PageSize blocks when all blocks are used.
+    inline void* allocate() {
+        if (Block *block = vacant_head) {
+            vacant_head = block->next_vacant;
+            return block;
+        }
+        return &blocks.push_back([](Block &) {}, [](auto &, auto &, size_t) {});
+    }
+
+    /// Pushes the block to the stack of vacant blocks.
+    /// Сomplexity O(1).
+    inline void deallocate(void *ptr) {
+        Block *block = static_cast<Block*>(ptr);
+        block->next_vacant = vacant_head;
+        vacant_head = block;
+    }
+
+    size_t memory_usage() const override {
+        return blocks.capacity() * sizeof(Block);
+    }
+};
+
+/// Pools of SlabAllocator and all its copies and rebinds, one pool per block size and alignment.
+template <size_t PageSize>
+class NodeArena {
+    std::vector<std::unique_ptr<NodePoolBase>> pools;
+
+public:
+    /// Returns the pool of blocks of Size bytes aligned to Align, creates it on the first call.
+    template <size_t Size, size_t Align>
+    NodePool<Size, Align, PageSize>& pool() {
+        using Pool = NodePool<Size, Align, PageSize>;
+        for (auto &pool : pools) {
+            if (pool->size == Size && pool->align == Align)
+                return static_cast<Pool&>(*pool);
+        }
+        pools.push_back(std::make_unique<Pool>());
+        return static_cast<Pool&>(*pools.back());
+    }
+
+    size_t memory_usage() const {
+        size_t res = 0;
+        for (auto &pool : pools)
+            res += pool->memory_usage();
+        return res;
+    }
+};
+
+} // namespace slab_detail
+
+/// Allocator of nodes of std::list, std::map, std::unordered_map and other node-based containers.
+///
+/// Single objects are allocated from the pool of blocks of their size: blocks are stored in pages of PageSize blocks
+/// that are never relocated, and deallocated blocks are reused last in first out, so inserting and erasing nodes
+/// is O(1) without calls of the global allocator and nodes stay close to each other in memory.
+/// Arrays (n != 1, for example buckets of std::unordered_map) are allocated by std::allocator.
+///
+/// A default constructed allocator creates the new arena of pools, copies and rebinds share it
+/// and compare equal, so memory is freed when the last allocator using the arena is destroyed.
+/// Memory of pools is kept for reuse until then, pages aren't returned while the arena lives.
+/// Not thread-safe: containers sharing the arena must be used from one thread at a time.
+template <class T, size_t PageSize = 256>
+class SlabAllocator {
+    using Arena = slab_detail::NodeArena<PageSize>;
+    using Pool = slab_detail::NodePool<sizeof(T), alignof(T), PageSize>;
+
+    template <class U, size_t P>
+    friend class SlabAllocator;
+
+    std::shared_ptr<Arena> arena;
+    /// Pool of blocks for T, looked up in the arena on the first use, so copies and rebinds never throw.
+    Pool *pool = nullptr;
+
+    inline Pool& node_pool() {
+        if (!pool)
+            pool = &arena->template pool<sizeof(T), alignof(T)>();
+        return *pool;
+    }
+
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <class U>
+    struct rebind {
+        using other = SlabAllocator<U, PageSize>;
+    };
+
+    /// Constructs the allocator with the new arena.
+    SlabAllocator() : arena(std::make_shared<Arena>()) {}
+
+    /// Copies share the arena, moving copies too, so moved from containers stay usable.
+    SlabAllocator(const SlabAllocator &other) noexcept : arena(other.arena), pool(other.pool) {}
+
+    template <class U>
+    SlabAllocator(const SlabAllocator<U, PageSize> &other) noexcept : arena(other.arena) {}
+
+    SlabAllocator& operator=(const SlabAllocator &other) noexcept {
+        arena = other.arena;
+        pool = other.pool;
+        return *this;
+    }
+
+    /// Allocates memory for n objects, a block of the pool if n is 1.
+    /// Сomplexity O(1).
+    inline T* allocate(size_t n) {
+        if (n != 1)
+            return std::allocator<T>().allocate(n);
+        return static_cast<T*>(node_pool().allocate());
+    }
+
+    /// Deallocates memory allocated by an equal allocator, the block returns to the pool and is reused first.
+    /// Сomplexity O(1).
+    inline void deallocate(T *ptr, size_t n) {
+        if (n != 1)
+            std::allocator<T>().deallocate(ptr, n);
+        else
+            node_pool().deallocate(ptr);
+    }
+
+    /// Returns the number of bytes of pages of all pools of the arena.
+    /// Arrays allocated by std::allocator aren't counted.
+    inline size_t memory_usage() const {
+        return arena->memory_usage();
+    }
+
+    template <class A, class B, size_t P>
+    friend bool operator==(const SlabAllocator<A, P> &a, const SlabAllocator<B, P> &b);
+};
+
+/// Allocators are equal if they share the arena, then each one deallocates memory allocated by the other.
+template <class A, class B, size_t PageSize>
+inline bool operator==(const SlabAllocator<A, PageSize> &a, const SlabAllocator<B, PageSize> &b) {
+    return a.arena == b.arena;
+}
+
+template <class A, class B, size_t PageSize>
+inline bool operator!=(const SlabAllocator<A, PageSize> &a, const SlabAllocator<B, PageSize> &b) {
+    return !(a == b);
+}
+
+#endif
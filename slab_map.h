@@ -0,0 +1,205 @@
+#ifndef SLAB_MAP_H
+#define SLAB_MAP_H
+
+#include "slab.h"
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+/// Container of objects with stable keys where objects are densely packed in one array (sparse set).
+///
+/// Objects are stored in std::vector without holes, so iteration is the iteration of the vector.
+/// Keys are keys of the sparse slab that maps them to positions of objects in the array,
+/// so get() is one extra indirection. Removing moves the last object to the position of the removed one,
+/// so the order of objects is the insertion order until the first removing and keys stay unchanged.
+///
+/// Objects must be move assignable.
+/// Keys are configured by Traits same as keys of the slab: key_type, generation_bits and the reuse policy.
+/// Suits workloads that iterate all objects more often than insert and remove, for example components of ECS.
+/// References to objects are invalidated by inserting (the array may grow) and removing (the last object is moved).
+template <class T, class Traits = SlabTraits>
+class SlabMap {
+public:
+    using key_type = typename Traits::key_type;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+private:
+    /// Positions of objects in the array by keys.
+    Slab<key_type, Traits> sparse;
+    /// Objects without holes.
+    std::vector<T> values;
+    /// Keys of objects by positions in the array.
+    std::vector<key_type> dense_keys;
+
+    /// Registers the object appended to the array and returns the key of it.
+    inline key_type append_key() {
+        try {
+            dense_keys.push_back(0);
+            key_type key = sparse.insert(key_type(values.size() - 1));
+            dense_keys.back() = key;
+            return key;
+        } catch (...) {
+            if (dense_keys.size() == values.size())
+                dense_keys.pop_back();
+            values.pop_back();
+            throw;
+        }
+    }
+
+public:
+    SlabMap() = default;
+
+    /// Constructs the container with the capacity for the specified number of objects.
+    explicit SlabMap(size_t capacity)
+        : sparse(capacity) {
+        reserve(capacity);
+    }
+
+    /// Allocates memory for the specified number of objects.
+    void reserve(size_t capacity) {
+        values.reserve(capacity);
+        dense_keys.reserve(capacity);
+    }
+
+    /// Inserts a object to the end of the array and return the key of it.
+    /// Сomplexity O(1) amortized, the array grows same as std::vector.
+    inline key_type insert(T &&obj) {
+        values.push_back(std::move(obj));
+        return append_key();
+    }
+
+    /// Inserts a object to the end of the array and return the key of it.
+    /// Сomplexity O(1) amortized, the array grows same as std::vector.
+    inline key_type insert(const T &obj) {
+        values.push_back(obj);
+        return append_key();
+    }
+
+    /// Constructs a object in place at the end of the array and return the key of it.
+    /// Сomplexity O(1) amortized, the array grows same as std::vector.
+    template <class... Args>
+    inline key_type emplace(Args&&... args) {
+        values.emplace_back(std::forward<Args>(args)...);
+        return append_key();
+    }
+
+    /// Returns true if the object by the key exist or false if it doesn't.
+    /// Сomplexity O(1).
+    inline bool contains(key_type key) const {
+        return sparse.contains(key);
+    }
+
+    /// Returns a pointer to the object by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    inline T* try_get(key_type key) {
+        const key_type *pos = sparse.try_get(key);
+        return pos ? &values[*pos] : nullptr;
+    }
+
+    /// Returns a const pointer to the object by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    inline const T* try_get(key_type key) const {
+        const key_type *pos = sparse.try_get(key);
+        return pos ? &values[*pos] : nullptr;
+    }
+
+    /// Returns a reference to the object by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1), one indirection through the sparse slab.
+    inline T& get(key_type key) {
+        return values[sparse.get(key)];
+    }
+
+    /// Returns a const reference to the object by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1), one indirection through the sparse slab.
+    inline const T& get(key_type key) const {
+        return values[sparse.get(key)];
+    }
+
+    /// Removes object by the key, the last object is moved to its position.
+    /// Returns false if obect by key not exist.
+    /// Сomplexity O(1).
+    bool remove(key_type key) {
+        key_type *pos = sparse.try_get(key);
+        if (!pos)
+            return false;
+
+        size_t index = *pos;
+        size_t last = values.size() - 1;
+        if (index != last) {
+            values[index] = std::move(values[last]);
+            dense_keys[index] = dense_keys[last];
+            sparse.get(dense_keys[index]) = key_type(index);
+        }
+        values.pop_back();
+        dense_keys.pop_back();
+        sparse.remove(key);
+        return true;
+    }
+
+    /// Move object by the key, the last object is moved to its position.
+    /// Returns moved stored object or std::nullopt if obect by key not exist.
+    /// Сomplexity O(1).
+    std::optional<T> take(key_type key) {
+        std::optional<T> res = std::nullopt;
+        if (const key_type *pos = sparse.try_get(key)) {
+            res.emplace(std::move(values[*pos]));
+            remove(key);
+        }
+        return res;
+    }
+
+    /// Removes all objects. Keys are released, with generations stale keys stay rejected.
+    /// Сomplexity O(n).
+    void clear() {
+        sparse.remove_keys(dense_keys.begin(), dense_keys.end());
+        values.clear();
+        dense_keys.clear();
+    }
+
+    /// Returns determined the key what will assigned for next added object.
+    /// Сomplexity O(1).
+    inline key_type vacant_key() const {
+        return sparse.vacant_key();
+    }
+
+    /// Returns the number of stored objects.
+    inline size_t size() const {
+        return values.size();
+    }
+
+    /// Returns true if there are no objects.
+    inline bool empty() const {
+        return values.empty();
+    }
+
+    /// Returns the pointer to the array of objects, size() objects without holes.
+    inline T* data() { return values.data(); }
+    inline const T* data() const { return values.data(); }
+
+    /// Returns the pointer to the array of keys of objects, the key of data()[i] is keys()[i].
+    inline const key_type* keys() const { return dense_keys.data(); }
+
+    /// Returns the position of the object by the key in the array or std::nullopt if the object doesn't exist.
+    /// Сomplexity O(1).
+    inline std::optional<size_t> index_of(key_type key) const {
+        const key_type *pos = sparse.try_get(key);
+        return pos ? std::optional<size_t>(*pos) : std::nullopt;
+    }
+
+    /// Iterators of the array, random access and contiguous.
+    inline iterator begin() { return values.begin(); }
+    inline iterator end() { return values.end(); }
+    inline const_iterator begin() const { return values.begin(); }
+    inline const_iterator end() const { return values.end(); }
+
+    /// Returns the number of bytes of the array, of keys and of the sparse slab.
+    inline size_t memory_usage() const {
+        return values.capacity() * sizeof(T) + dense_keys.capacity() * sizeof(key_type) + sparse.memory_usage();
+    }
+};
+
+#endif
@@ -0,0 +1,527 @@
+#ifndef STATIC_SLAB_H
+#define STATIC_SLAB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace slab_detail {
+
+/// Smallest unsigned type for links between N slots, its maximum value is the list end.
+template <size_t N>
+using StaticLink = std::conditional_t<(N < UINT8_MAX), uint8_t,
+                   std::conditional_t<(N < UINT16_MAX), uint16_t,
+                   std::conditional_t<(N < UINT32_MAX), uint32_t, uint64_t>>>;
+
+/// Returns number of trailing zero bits, the value must be non zero. Usable in constant expressions.
+constexpr unsigned static_ctz64(uint64_t val) {
+#if defined(__GNUC__) || defined(__clang__)
+    return unsigned(__builtin_ctzll(val));
+#else
+    // the lowest set bit multiplied by the de Bruijn sequence gives the unique index in the top 6 bits
+    constexpr unsigned char positions[64] = {
+        0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+    };
+    return positions[((val & (~val + 1)) * 0x03f79d71b4cb0a89ull) >> 58];
+#endif
+}
+
+/// Returns number of leading zero bits, the value must be non zero. Usable in constant expressions.
+constexpr unsigned static_clz64(uint64_t val) {
+#if defined(__GNUC__) || defined(__clang__)
+    return unsigned(__builtin_clzll(val));
+#else
+    unsigned res = 0;
+    for (unsigned shift = 32; shift != 0; shift >>= 1) {
+        if ((val >> (64 - shift - res)) == 0)
+            res += shift;
+    }
+    return res;
+#endif
+}
+
+/// Slot of the static slab: the object or the link to the next vacant slot.
+/// Has trivial destructor for trivially destructible objects, so the slab stays a literal type.
+template <class T, class Link, bool = std::is_trivially_destructible_v<T>>
+union StaticSlot {
+    Link next_vacant;
+    T value;
+
+    constexpr StaticSlot() : next_vacant(0) {}
+    constexpr explicit StaticSlot(Link next) : next_vacant(next) {}
+
+    template <class... Args>
+    constexpr explicit StaticSlot(std::in_place_t, Args&&... args) : value(std::forward<Args>(args)...) {}
+};
+
+template <class T, class Link>
+union StaticSlot<T, Link, false> {
+    Link next_vacant;
+    T value;
+
+    constexpr StaticSlot() : next_vacant(0) {}
+    constexpr explicit StaticSlot(Link next) : next_vacant(next) {}
+
+    template <class... Args>
+    constexpr explicit StaticSlot(std::in_place_t, Args&&... args) : value(std::forward<Args>(args)...) {}
+
+    ~StaticSlot() {}
+};
+
+/// Inline slots, occupancy bits and the list of vacant slots of the static slab.
+/// Trivially copyable objects are put to slots by assigning whole slots, which is allowed in constant expressions,
+/// other objects are constructed and destroyed in place.
+template <class T, size_t N>
+struct StaticSlabCore {
+    using Link = StaticLink<N>;
+    using Slot = StaticSlot<T, Link>;
+
+    static constexpr bool trivial = std::is_trivially_copyable_v<T>;
+    /// Index of the list end.
+    static constexpr Link no_vacant = std::numeric_limits<Link>::max();
+    static constexpr size_t words_num = (N + 63) / 64;
+
+    Slot slots[N];
+    /// Bitmap of occupied slots.
+    uint64_t occupancy[words_num] = {};
+    /// Number of used slots, occupied or vacant, slots after it were never used.
+    Link count = 0;
+    /// Head of the list of vacant slots.
+    Link vacant_head = no_vacant;
+    /// Number of vacant slots.
+    Link vacant_count = 0;
+
+    constexpr bool test(size_t index) const { return (occupancy[index >> 6] >> (index & 63)) & 1; }
+    constexpr void set(size_t index) { occupancy[index >> 6] |= uint64_t(1) << (index & 63); }
+    constexpr void reset(size_t index) { occupancy[index >> 6] &= ~(uint64_t(1) << (index & 63)); }
+
+    /// Returns the first occupied slot at or after index or count if there is no such slot.
+    /// Words without occupied slots are skipped at once, the slot in the word is found with ctz.
+    constexpr size_t find_next(size_t index) const {
+        if (index >= count)
+            return count;
+
+        size_t i = index >> 6;
+        uint64_t word = occupancy[i] >> (index & 63);
+        if (word != 0)
+            return index + static_ctz64(word);
+
+        for (++i; i < words_num && (i << 6) < count; ++i) {
+            if (occupancy[i] != 0)
+                return (i << 6) + static_ctz64(occupancy[i]);
+        }
+        return count;
+    }
+
+    /// Returns the last occupied slot before index or count if there is no such slot.
+    constexpr size_t find_prev(size_t index) const {
+        if (index == 0)
+            return count;
+
+        size_t i = (index - 1) >> 6;
+        uint64_t word = occupancy[i] & (~uint64_t(0) >> (63 - ((index - 1) & 63)));
+        for (;;) {
+            if (word != 0)
+                return (i << 6) + 63 - static_clz64(word);
+            if (i == 0)
+                return count;
+            word = occupancy[--i];
+        }
+    }
+
+    /// Constructs the object in the vacant slot. If the constructor throws, the slot keeps its link.
+    template <class... Args>
+    constexpr void construct(size_t index, Args&&... args) {
+        if constexpr (trivial)
+            slots[index] = Slot(std::in_place, std::forward<Args>(args)...);
+        else
+            construct_in_place(index, std::forward<Args>(args)...);
+    }
+
+    /// Constructs the object over the link of the vacant slot and restores the link if the constructor throws.
+    /// Not constexpr, try blocks aren't allowed in constant expressions.
+    template <class... Args>
+    void construct_in_place(size_t index, Args&&... args) {
+        Link link = slots[index].next_vacant;
+        try {
+            ::new (static_cast<void*>(&slots[index].value)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            slots[index].next_vacant = link;
+            throw;
+        }
+    }
+
+    /// Destroys the object and links the slot to the next vacant slot.
+    constexpr void vacate(size_t index, Link next) {
+        if constexpr (trivial) {
+            slots[index] = Slot(next);
+        } else {
+            slots[index].value.~T();
+            slots[index].next_vacant = next;
+        }
+    }
+
+    /// Destroys all objects, the slab becomes empty.
+    constexpr void clear() {
+        if constexpr (!trivial) {
+            for (size_t i = find_next(0); i < count; i = find_next(i + 1))
+                slots[i].value.~T();
+        }
+        for (uint64_t &word : occupancy)
+            word = 0;
+        count = 0;
+        vacant_head = no_vacant;
+        vacant_count = 0;
+    }
+
+    /// Copies (or moves if other is rvalue) objects and links of vacant slots of other empty slab, so keys are kept.
+    /// If copying an object throws, copied objects are destroyed and this slab stays empty.
+    template <class Other>
+    void construct_from(Other &&other) {
+        size_t i = 0;
+        try {
+            for (; i < other.count; ++i) {
+                if (other.test(i))
+                    construct(i, std::forward<Other>(other).slots[i].value);
+                else
+                    slots[i].next_vacant = other.slots[i].next_vacant;
+            }
+        } catch (...) {
+            while (i-- > 0) {
+                if (other.test(i))
+                    slots[i].value.~T();
+            }
+            throw;
+        }
+        for (size_t i = 0; i < words_num; ++i)
+            occupancy[i] = other.occupancy[i];
+        count = other.count;
+        vacant_head = other.vacant_head;
+        vacant_count = other.vacant_count;
+    }
+};
+
+/// Storage of trivially copyable objects, copying and destroying are trivial.
+template <class T, size_t N, bool = std::is_trivially_copyable_v<T>>
+struct StaticSlabStorage : StaticSlabCore<T, N> {};
+
+/// Storage of other objects, copies and destroys stored objects one by one.
+template <class T, size_t N>
+struct StaticSlabStorage<T, N, false> : StaticSlabCore<T, N> {
+    StaticSlabStorage() = default;
+
+    StaticSlabStorage(const StaticSlabStorage &other) {
+        this->construct_from(other);
+    }
+
+    StaticSlabStorage(StaticSlabStorage &&other) {
+        this->construct_from(std::move(other));
+    }
+
+    StaticSlabStorage& operator=(const StaticSlabStorage &other) {
+        if (this != &other) {
+            this->clear();
+            this->construct_from(other);
+        }
+        return *this;
+    }
+
+    StaticSlabStorage& operator=(StaticSlabStorage &&other) {
+        if (this != &other) {
+            this->clear();
+            this->construct_from(std::move(other));
+        }
+        return *this;
+    }
+
+    ~StaticSlabStorage() {
+        this->clear();
+    }
+};
+
+} // namespace slab_detail
+
+/// Slab container with fixed capacity of N objects stored inline in the container itself.
+///
+/// Same logic as Slab: vacant slots of removed objects are linked to the list threaded through the slots
+/// and reused first, keys are slot indexes. Nothing is ever allocated, insert throws std::length_error when full.
+/// Links are the smallest unsigned type holding N, so small slabs of small objects have no overhead.
+///
+/// For trivially copyable objects the slab is a literal type and all methods are constexpr,
+/// so it can be filled and used in constant expressions. Copying and moving copy the objects like std::array does.
+template <class T, size_t N>
+class StaticSlab : slab_detail::StaticSlabStorage<T, N> {
+    static_assert(N > 0, "StaticSlab capacity must not be zero.");
+
+    using Core = slab_detail::StaticSlabCore<T, N>;
+    using Link = typename Core::Link;
+    using Core::no_vacant;
+
+public:
+    using key_type = size_t;
+
+    /// Constructs a new empty slab.
+    constexpr StaticSlab() = default;
+
+    /// Constructs a new slab with values from initializer_list, keys are positions in the list.
+    /// Throws std::length_error if there are more than N values.
+    constexpr StaticSlab(std::initializer_list<T> init) {
+        for (const T &val : init)
+            insert(val);
+    }
+
+    /// Inserts a object and return the key of it in the slab.
+    /// Key of the last removed object is reused first.
+    /// Сomplexity O(1). Throws std::length_error if the slab is full.
+    constexpr key_type insert(T &&obj) {
+        return emplace(std::move(obj));
+    }
+
+    /// Inserts a object and return the key of it in the slab.
+    /// Key of the last removed object is reused first.
+    /// Сomplexity O(1). Throws std::length_error if the slab is full.
+    constexpr key_type insert(const T &obj) {
+        return emplace(obj);
+    }
+
+    /// Constructs a object in place from the arguments and return the key of it in the slab.
+    /// Сomplexity O(1). Throws std::length_error if the slab is full.
+    template <class... Args>
+    constexpr key_type emplace(Args&&... args) {
+        if (full())
+            throw std::length_error("StaticSlab is full");
+
+        // the slot is taken from the list only after the object is constructed and construct() restores
+        // the link overwritten by the throwing constructor, so throwing leaves the slab intact
+        if (this->vacant_head == no_vacant) {
+            size_t index = this->count;
+            this->construct(index, std::forward<Args>(args)...);
+            ++this->count;
+            this->set(index);
+            return index;
+        }
+
+        size_t index = this->vacant_head;
+        Link next = this->slots[index].next_vacant;
+        this->construct(index, std::forward<Args>(args)...);
+        this->vacant_head = next;
+        --this->vacant_count;
+        this->set(index);
+        return index;
+    }
+
+    /// Returns true if the object by the key exist or false if it doesn't.
+    constexpr bool contains(key_type key) const {
+        return key < this->count && this->test(key);
+    }
+
+    /// Returns a pointer to the object in the slab by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    constexpr T* try_get(key_type key) {
+        return contains(key) ? &this->slots[key].value : nullptr;
+    }
+
+    /// Returns a const pointer to the object in the slab by the key or nullptr if the object doesn't exist.
+    /// Сomplexity O(1).
+    constexpr const T* try_get(key_type key) const {
+        return contains(key) ? &this->slots[key].value : nullptr;
+    }
+
+    /// Returns a reference to the object in the slab by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1).
+    constexpr T& get(key_type key) {
+        return this->slots[key].value;
+    }
+
+    /// Returns a const reference to the object in the slab by the key.
+    /// If the object by key doesn't exist then undefined behavior.
+    /// Сomplexity O(1).
+    constexpr const T& get(key_type key) const {
+        return this->slots[key].value;
+    }
+
+    /// Removes object from the slab by the key.
+    /// Returns false if obect by key not exist.
+    /// Сomplexity O(1).
+    constexpr bool remove(key_type key) {
+        if (!contains(key))
+            return false;
+
+        this->vacate(key, this->vacant_head);
+        this->reset(key);
+        this->vacant_head = Link(key);
+        ++this->vacant_count;
+        return true;
+    }
+
+    /// Move object from the slab by the key.
+    /// Returns moved stored object or std::nullopt if obect by key not exist.
+    /// Сomplexity O(1).
+    constexpr std::optional<T> take(key_type key) {
+        if (!contains(key))
+            return std::nullopt;
+
+        std::optional<T> res(std::move(this->slots[key].value));
+        remove(key);
+        return res;
+    }
+
+    /// Returns the key what will be assigned for next added object.
+    /// If the slab is full returns N.
+    /// Сomplexity O(1).
+    constexpr key_type vacant_key() const {
+        return this->vacant_head != no_vacant ? key_type(this->vacant_head) : key_type(this->count);
+    }
+
+    /// Removes all objects.
+    /// Сomplexity O(n) where n is the number of used slots.
+    constexpr void clear() {
+        Core::clear();
+    }
+
+    /// Returns the number of stored objects.
+    /// Сomplexity O(1).
+    constexpr size_t size() const {
+        return size_t(this->count) - this->vacant_count;
+    }
+
+    /// Returns true if there are no objects stored in the slab.
+    /// Сomplexity O(1).
+    constexpr bool empty() const {
+        return size() == 0;
+    }
+
+    /// Returns true if no more objects can be inserted.
+    /// Сomplexity O(1).
+    constexpr bool full() const {
+        return size() == N;
+    }
+
+    /// Returns the maximum number of objects.
+    static constexpr size_t capacity() {
+        return N;
+    }
+
+    /// Bidirectional iterator over objects in order of keys, vacant slots are skipped with occupancy bits.
+    template <bool Const>
+    class BasicIterator {
+    protected:
+        using Owner = std::conditional_t<Const, const StaticSlab, StaticSlab>;
+
+        Owner *slab;
+        /// Index of the slot.
+        size_t pos;
+
+        constexpr BasicIterator(Owner *slab, size_t pos) : slab(slab), pos(slab->find_next(pos)) {}
+
+        friend StaticSlab;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = T;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+
+        constexpr reference operator*() const { return slab->slots[pos].value; }
+        constexpr pointer operator->() const { return &slab->slots[pos].value; }
+
+        /// Returns the key of the object.
+        constexpr key_type key() const { return pos; }
+
+        constexpr BasicIterator& operator++() {
+            pos = slab->find_next(pos + 1);
+            return *this;
+        }
+
+        constexpr BasicIterator operator++(int) {
+            BasicIterator res = *this;
+            ++*this;
+            return res;
+        }
+
+        /// Moves to the previous object, stays at the first slot if there is no previous object same as Slab::Iterator.
+        constexpr BasicIterator& operator--() {
+            size_t prev = slab->find_prev(pos);
+            pos = prev == slab->count ? 0 : prev;
+            return *this;
+        }
+
+        constexpr BasicIterator operator--(int) {
+            BasicIterator res = *this;
+            --*this;
+            return res;
+        }
+
+        friend constexpr bool operator==(const BasicIterator &a, const BasicIterator &b) { return a.pos == b.pos; }
+        friend constexpr bool operator!=(const BasicIterator &a, const BasicIterator &b) { return a.pos != b.pos; }
+    };
+
+    /// Iterator where dereferencing presented as key value pair, same as Slab::KeyValIterator.
+    template <bool Const>
+    class BasicKeyValIterator : public BasicIterator<Const> {
+        using Base = BasicIterator<Const>;
+
+        constexpr explicit BasicKeyValIterator(const Base &it) : Base(it) {}
+
+        friend StaticSlab;
+
+    public:
+        using value_type = std::pair<key_type, T>;
+        using pointer    = void;
+        using reference  = std::pair<key_type, typename Base::reference>;
+
+        constexpr reference operator*() const { return reference(this->pos, this->slab->slots[this->pos].value); }
+
+        constexpr BasicKeyValIterator& operator++() {
+            Base::operator++();
+            return *this;
+        }
+
+        constexpr BasicKeyValIterator operator++(int) {
+            BasicKeyValIterator res = *this;
+            ++*this;
+            return res;
+        }
+
+        constexpr BasicKeyValIterator& operator--() {
+            Base::operator--();
+            return *this;
+        }
+
+        constexpr BasicKeyValIterator operator--(int) {
+            BasicKeyValIterator res = *this;
+            --*this;
+            return res;
+        }
+    };
+
+    using Iterator = BasicIterator<false>;
+    using ConstIterator = BasicIterator<true>;
+    using KeyValIterator = BasicKeyValIterator<false>;
+    using ConstKeyValIterator = BasicKeyValIterator<true>;
+
+    constexpr Iterator begin() { return Iterator(this, 0); }
+    constexpr Iterator end() { return Iterator(this, this->count); }
+    constexpr ConstIterator begin() const { return ConstIterator(this, 0); }
+    constexpr ConstIterator end() const { return ConstIterator(this, this->count); }
+
+    /// Returns iterator to the beginning, dereferencing it presented as key value pair.
+    constexpr KeyValIterator key_val_begin() { return KeyValIterator(begin()); }
+    constexpr KeyValIterator key_val_end() { return KeyValIterator(end()); }
+    constexpr ConstKeyValIterator key_val_begin() const { return ConstKeyValIterator(begin()); }
+    constexpr ConstKeyValIterator key_val_end() const { return ConstKeyValIterator(end()); }
+};
+
+#endif
@@ -0,0 +1,455 @@
+/// Benchmarks of Slab against std::vector, std::unordered_map and std::list,
+/// node containers with std::allocator and with SlabAllocator.
+///
+/// Every case measures one operation in batches and reports percentiles of nanoseconds per operation,
+/// so regressions can be tracked by comparing outputs of runs.
+/// Output is CSV by default or JSON with --json.
+/// SlabMap is measured as slab_map.
+/// Slab is measured with every reuse policy of vacant slots: slab (lifo), slab_fifo and slab_lowest.
+///
+/// Usage: slab_bench [--json] [--n elements] [--filter substring]
+///   --n       number of inserted elements before removing to the fill ratio, 200000 by default
+///   --filter  runs only cases whose name (container/op/size/fill/pattern) contains the substring
+///
+/// Build with optimizations, the CMake target slab_bench is built in Release by default.
+
+#include "../slab.h"
+#include "../slab_allocator.h"
+#include "../slab_map.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace chrono;
+
+/// Element of the specified size in bytes.
+template <size_t Size>
+struct Element {
+    uint64_t data[Size / sizeof(uint64_t)];
+
+    explicit Element(uint64_t val) {
+        for (uint64_t &word : data)
+            word = val;
+    }
+};
+
+/// Simple fast deterministic random generator, same sequence on every run.
+struct Random {
+    uint64_t state = 88172645463325252ull;
+
+    inline uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+/// Prevents the compiler from removing reads of elements.
+volatile uint64_t sink;
+
+/// Containers are used through adapters with the same interface.
+/// Every adapter keeps handles of live elements, so elements are picked by the position in that list.
+/// Removing swaps the last handle into the position, same work for every container.
+
+/// Slab with the reuse policy of vacant slots.
+template <SlabReuse Reuse>
+struct ReuseTraits : SlabTraits {
+    static constexpr SlabReuse reuse = Reuse;
+};
+
+template <SlabReuse Reuse>
+struct SlabAdapter {
+    static constexpr const char *name = Reuse == SlabReuse::lifo ? "slab" : Reuse == SlabReuse::fifo ? "slab_fifo" : "slab_lowest";
+
+    template <class T>
+    struct Container {
+        Slab<T, ReuseTraits<Reuse>> slab;
+        vector<size_t> live;
+
+        inline void insert(uint64_t val) { live.push_back(slab.insert(T(val))); }
+        inline void remove_at(size_t pos) {
+            slab.remove(live[pos]);
+            live[pos] = live.back();
+            live.pop_back();
+        }
+        inline T& get_at(size_t pos) { return slab.get(live[pos]); }
+        inline size_t size() const { return live.size(); }
+        template <class F>
+        inline void for_each(F f) {
+            for (T &val : slab)
+                f(val);
+        }
+        template <class F>
+        inline void for_each_run(F f) {
+            slab.for_each_run([&](size_t, auto run) {
+                for (T &val : run)
+                    f(val);
+            });
+        }
+    };
+};
+
+/// Dense SlabMap: objects without holes, keys through the sparse slab.
+struct SlabMapAdapter {
+    static constexpr const char *name = "slab_map";
+
+    template <class T>
+    struct Container {
+        SlabMap<T> map;
+        vector<size_t> live;
+
+        inline void insert(uint64_t val) { live.push_back(map.insert(T(val))); }
+        inline void remove_at(size_t pos) {
+            map.remove(live[pos]);
+            live[pos] = live.back();
+            live.pop_back();
+        }
+        inline T& get_at(size_t pos) { return map.get(live[pos]); }
+        inline size_t size() const { return live.size(); }
+        template <class F>
+        inline void for_each(F f) {
+            for (T &val : map)
+                f(val);
+        }
+    };
+};
+
+/// True if the container iterates runs of contiguous elements.
+template <class Container, class = void>
+struct HasRuns : std::false_type {};
+
+template <class Container>
+struct HasRuns<Container, std::void_t<decltype(&Container::template for_each_run<void (*)(int&)>)>> : std::true_type {};
+
+/// Vector has no stable handles: positions are indexes and removing moves the last element to the hole.
+struct VectorAdapter {
+    static constexpr const char *name = "vector";
+
+    template <class T>
+    struct Container {
+        vector<T> vec;
+
+        inline void insert(uint64_t val) { vec.emplace_back(val); }
+        inline void remove_at(size_t pos) {
+            vec[pos] = std::move(vec.back());
+            vec.pop_back();
+        }
+        inline T& get_at(size_t pos) { return vec[pos]; }
+        inline size_t size() const { return vec.size(); }
+        template <class F>
+        inline void for_each(F f) {
+            for (T &val : vec)
+                f(val);
+        }
+    };
+};
+
+/// Node containers are measured with std::allocator and with SlabAllocator (names with the _slab_alloc suffix).
+template <bool SlabNodes>
+struct UnorderedMapAdapter {
+    static constexpr const char *name = SlabNodes ? "unordered_map_slab_alloc" : "unordered_map";
+
+    template <class T>
+    struct Container {
+        using Value = pair<const uint64_t, T>;
+        using Alloc = conditional_t<SlabNodes, SlabAllocator<Value>, allocator<Value>>;
+
+        unordered_map<uint64_t, T, hash<uint64_t>, equal_to<uint64_t>, Alloc> map;
+        vector<uint64_t> live;
+        uint64_t next_key = 0;
+
+        inline void insert(uint64_t val) {
+            map.emplace(next_key, T(val));
+            live.push_back(next_key++);
+        }
+        inline void remove_at(size_t pos) {
+            map.erase(live[pos]);
+            live[pos] = live.back();
+            live.pop_back();
+        }
+        inline T& get_at(size_t pos) { return map.find(live[pos])->second; }
+        inline size_t size() const { return live.size(); }
+        template <class F>
+        inline void for_each(F f) {
+            for (auto &item : map)
+                f(item.second);
+        }
+    };
+};
+
+template <bool SlabNodes>
+struct ListAdapter {
+    static constexpr const char *name = SlabNodes ? "list_slab_alloc" : "list";
+
+    template <class T>
+    struct Container {
+        using List = list<T, conditional_t<SlabNodes, SlabAllocator<T>, allocator<T>>>;
+
+        List items;
+        vector<typename List::iterator> live;
+
+        inline void insert(uint64_t val) { live.push_back(items.emplace(items.end(), val)); }
+        inline void remove_at(size_t pos) {
+            items.erase(live[pos]);
+            live[pos] = live.back();
+            live.pop_back();
+        }
+        inline T& get_at(size_t pos) { return *live[pos]; }
+        inline size_t size() const { return live.size(); }
+        template <class F>
+        inline void for_each(F f) {
+            for (T &val : items)
+                f(val);
+        }
+    };
+};
+
+struct Options {
+    bool json = false;
+    size_t n = 200000;
+    string filter;
+};
+
+/// Measured case.
+struct Result {
+    string container;
+    string op;
+    size_t element_size;
+    double fill;
+    string pattern;
+    size_t elements;
+    vector<double> samples;
+};
+
+/// Returns the percentile of sorted samples.
+double percentile(const vector<double> &sorted, double p) {
+    size_t pos = size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+    return sorted[min(pos, sorted.size() - 1)];
+}
+
+void print_header(const Options &options) {
+    if (options.json)
+        printf("[\n");
+    else
+        printf("container,op,element_size,fill,pattern,elements,samples,ns_min,ns_p50,ns_p90,ns_p99,ns_mean\n");
+}
+
+void print_result(const Options &options, Result &res, bool first) {
+    sort(res.samples.begin(), res.samples.end());
+    double mean = 0;
+    for (double sample : res.samples)
+        mean += sample;
+    mean /= double(res.samples.size());
+
+    if (options.json) {
+        printf("%s  {\"container\": \"%s\", \"op\": \"%s\", \"element_size\": %zu, \"fill\": %.2f, \"pattern\": \"%s\", "
+               "\"elements\": %zu, \"samples\": %zu, \"ns_min\": %.2f, \"ns_p50\": %.2f, \"ns_p90\": %.2f, "
+               "\"ns_p99\": %.2f, \"ns_mean\": %.2f}",
+               first ? "" : ",\n", res.container.c_str(), res.op.c_str(), res.element_size, res.fill,
+               res.pattern.c_str(), res.elements, res.samples.size(), res.samples.front(),
+               percentile(res.samples, 50), percentile(res.samples, 90), percentile(res.samples, 99), mean);
+    } else {
+        printf("%s,%s,%zu,%.2f,%s,%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+               res.container.c_str(), res.op.c_str(), res.element_size, res.fill, res.pattern.c_str(),
+               res.elements, res.samples.size(), res.samples.front(),
+               percentile(res.samples, 50), percentile(res.samples, 90), percentile(res.samples, 99), mean);
+    }
+    fflush(stdout);
+}
+
+void print_footer(const Options &options) {
+    if (options.json)
+        printf("\n]\n");
+}
+
+/// Number of operations timed together, so the clock overhead is negligible.
+constexpr size_t batch = 256;
+/// Number of timed batches of one case.
+constexpr size_t rounds = 200;
+/// Number of timed full passes of iteration.
+constexpr size_t iterate_rounds = 20;
+
+/// Runs all operations for one container, element size and fill ratio.
+/// The container gets n elements, then random elements are removed to the fill ratio,
+/// so the slab has vacant slots among objects and node containers have freed nodes.
+template <class Adapter, size_t Size>
+void run_cases(const Options &options, double fill, bool &first) {
+    using T = Element<Size>;
+    using Container = typename Adapter::template Container<T>;
+
+    auto run = [&](const char *op, const char *pattern, auto &&measure) {
+        char name[128];
+        snprintf(name, sizeof(name), "%s/%s/%zu/%.2f/%s", Adapter::name, op, Size, fill, pattern);
+        if (!options.filter.empty() && !strstr(name, options.filter.c_str()))
+            return;
+
+        Container container;
+        Random rnd;
+        for (size_t i = 0; i < options.n; ++i)
+            container.insert(i);
+        size_t target = size_t(double(options.n) * fill);
+        while (container.size() > target)
+            container.remove_at(rnd.next() % container.size());
+
+        Result res { Adapter::name, op, Size, fill, pattern, container.size(), {} };
+        measure(container, rnd, res.samples);
+        if (res.samples.empty())
+            return;
+        print_result(options, res, first);
+        first = false;
+    };
+
+    auto time_batch = [](auto &&ops) {
+        auto start = steady_clock::now();
+        ops();
+        return double(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+    };
+
+    // inserting to the container without freed slots and nodes, the filled container is not used
+    run("insert", "append", [&](Container &, Random &, vector<double> &samples) {
+        Container appended;
+        for (size_t round = 0; round < rounds; ++round) {
+            samples.push_back(time_batch([&] {
+                for (size_t i = 0; i < batch; ++i)
+                    appended.insert(i);
+            }) / batch);
+        }
+    });
+
+    // inserting reuses slots and nodes freed by the previous batch
+    run("insert", "reuse", [&](Container &c, Random &, vector<double> &samples) {
+        for (size_t round = 0; round < rounds; ++round) {
+            samples.push_back(time_batch([&] {
+                for (size_t i = 0; i < batch; ++i)
+                    c.insert(i);
+            }) / batch);
+            for (size_t i = 0; i < batch; ++i)
+                c.remove_at(c.size() - 1);
+        }
+    });
+
+    run("remove", "random", [&](Container &c, Random &rnd, vector<double> &samples) {
+        for (size_t round = 0; round < rounds && c.size() > batch; ++round) {
+            samples.push_back(time_batch([&] {
+                for (size_t i = 0; i < batch; ++i)
+                    c.remove_at(rnd.next() % c.size());
+            }) / batch);
+            for (size_t i = 0; i < batch; ++i)
+                c.insert(i);
+        }
+    });
+
+    for (bool random : { false, true }) {
+        run("get", random ? "random" : "sequential", [&](Container &c, Random &rnd, vector<double> &samples) {
+            if (c.size() == 0)
+                return;
+            vector<size_t> positions(batch);
+            size_t next = 0;
+            for (size_t round = 0; round < rounds; ++round) {
+                for (size_t &pos : positions)
+                    pos = random ? rnd.next() % c.size() : next++ % c.size();
+                uint64_t sum = 0;
+                samples.push_back(time_batch([&] {
+                    for (size_t pos : positions)
+                        sum += c.get_at(pos).data[0];
+                }) / batch);
+                sink = sum;
+            }
+        });
+    }
+
+    for (bool churned : { false, true }) {
+        run("iterate", churned ? "after_churn" : "sequential", [&](Container &c, Random &rnd, vector<double> &samples) {
+            if (c.size() == 0)
+                return;
+            // random removes and inserts, as many as elements, so the reuse policy shapes the layout
+            if (churned) {
+                for (size_t i = 0; i < options.n; ++i) {
+                    c.remove_at(rnd.next() % c.size());
+                    c.insert(i);
+                }
+            }
+            for (size_t round = 0; round < iterate_rounds; ++round) {
+                uint64_t sum = 0;
+                samples.push_back(time_batch([&] {
+                    c.for_each([&](T &val) { sum += val.data[0]; });
+                }) / double(c.size()));
+                sink = sum;
+            }
+        });
+    }
+
+    if constexpr (HasRuns<Container>::value) {
+        run("iterate", "runs", [&](Container &c, Random &, vector<double> &samples) {
+            if (c.size() == 0)
+                return;
+            for (size_t round = 0; round < iterate_rounds; ++round) {
+                uint64_t sum = 0;
+                samples.push_back(time_batch([&] {
+                    c.for_each_run([&](T &val) { sum += val.data[0]; });
+                }) / double(c.size()));
+                sink = sum;
+            }
+        });
+    }
+
+    // steady state of removing random elements and inserting new ones
+    run("churn", "random", [&](Container &c, Random &rnd, vector<double> &samples) {
+        if (c.size() == 0)
+            return;
+        for (size_t round = 0; round < rounds; ++round) {
+            samples.push_back(time_batch([&] {
+                for (size_t i = 0; i < batch; ++i) {
+                    c.remove_at(rnd.next() % c.size());
+                    c.insert(i);
+                }
+            }) / batch);
+        }
+    });
+}
+
+template <class Adapter>
+void run_container(const Options &options, bool &first) {
+    for (double fill : { 1.0, 0.5, 0.1 }) {
+        run_cases<Adapter, 8>(options, fill, first);
+        run_cases<Adapter, 64>(options, fill, first);
+        run_cases<Adapter, 256>(options, fill, first);
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0) {
+            options.json = true;
+        } else if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) {
+            options.n = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--json] [--n elements] [--filter substring]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    bool first = true;
+    print_header(options);
+    run_container<SlabAdapter<SlabReuse::lifo>>(options, first);
+    run_container<SlabAdapter<SlabReuse::fifo>>(options, first);
+    run_container<SlabAdapter<SlabReuse::lowest>>(options, first);
+    run_container<SlabMapAdapter>(options, first);
+    run_container<VectorAdapter>(options, first);
+    run_container<UnorderedMapAdapter<false>>(options, first);
+    run_container<UnorderedMapAdapter<true>>(options, first);
+    run_container<ListAdapter<false>>(options, first);
+    run_container<ListAdapter<true>>(options, first);
+    print_footer(options);
+}
@@ -0,0 +1,316 @@
+/// Runs multi-threaded tests of ConcurrentSlab and ShardedSlab and return 0 if successful.
+/// Return 1 if some test fail.
+/// In fail case cout the function name and the line number
+/// of the place where was used the `FAIL` macro.
+///
+/// The function `main` at the end of the file.
+
+#include "../concurrent_slab.h"
+#include "../sharded_slab.h"
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// For easy debugging. By using FAIL macros will go to here
+void fail_end() {
+    exit(1); // place for breakpoint
+}
+
+/// Just std::cout the text with the function name where used this macro.
+#define TEST {cout << "start test " << __FUNCTION__ << std::endl;}
+/// std::cout text with the function name and the line where was used this macro. Makes the exit(1).
+#define FAIL {cout << "Fail in "<< __FUNCTION__ << ", file: "<< __FILE__ << ", line: " << __LINE__ << std::endl; fail_end();}
+
+using namespace std;
+using namespace chrono;
+
+/// Runs the function in the specified number of threads and waits them.
+template <class F>
+void run_threads(size_t threads_num, F f) {
+    vector<thread> threads;
+    for (size_t i = 0; i < threads_num; ++i)
+        threads.emplace_back(f, i);
+    for (auto &t : threads)
+        t.join();
+}
+
+void single_thread() {
+    TEST
+
+    ConcurrentSlab<string> slab;
+    if (!slab.empty())
+        FAIL
+
+    auto key0 = slab.insert("zero");
+    auto key1 = slab.emplace(3, 'a');
+    if (slab.size() != 2 || slab.get(key0) != "zero" || slab.get(key1) != "aaa")
+        FAIL
+
+    if (!slab.remove(key0) || slab.remove(key0) || slab.contains(key0))
+        FAIL
+
+    // slot is reused with the new generation
+    auto key2 = slab.insert("two");
+    if (uint32_t(key2) != uint32_t(key0) || key2 == key0 || slab.contains(key0) || slab.take(key0))
+        FAIL
+
+    optional<string> taken = slab.take(key2);
+    if (!taken || *taken != "two" || slab.contains(key2) || slab.size() != 1)
+        FAIL
+
+    // not issued keys
+    if (slab.contains(12345) || slab.contains(uint64_t(2) << 32) || slab.remove(uint64_t(2) << 32 | 1))
+        FAIL
+
+    vector<ConcurrentSlab<int>::key_type> keys;
+    ConcurrentSlab<int> ints;
+    for (int i = 0; i < 100000; ++i)
+        keys.push_back(ints.insert(i));
+    for (int i = 0; i < 100000; ++i) {
+        if (ints.get(keys[i]) != i)
+            FAIL
+    }
+}
+
+void stress() {
+    TEST
+
+    size_t threads_num = 8;
+    size_t ops = 200000;
+    ConcurrentSlab<size_t> slab;
+    vector<size_t> alive(threads_num);
+
+    run_threads(threads_num, [&](size_t thread_id) {
+        vector<pair<uint64_t, size_t>> own;
+        vector<uint64_t> removed;
+        uint64_t rnd = 88172645463325252ull + thread_id;
+        for (size_t i = 0; i < ops; ++i) {
+            rnd ^= rnd << 13; rnd ^= rnd >> 7; rnd ^= rnd << 17;
+            if (own.empty() || rnd % 3 != 0) {
+                size_t val = thread_id << 32 | i;
+                own.emplace_back(slab.insert(val), val);
+            } else {
+                size_t pos = rnd % own.size();
+                auto [key, val] = own[pos];
+                if (slab.get(key) != val)
+                    FAIL
+
+                if (rnd % 2) {
+                    if (!slab.remove(key))
+                        FAIL
+                } else {
+                    optional<size_t> taken = slab.take(key);
+                    if (!taken || *taken != val)
+                        FAIL
+                }
+                removed.push_back(key);
+                own[pos] = own.back();
+                own.pop_back();
+            }
+        }
+
+        for (auto [key, val] : own) {
+            if (!slab.contains(key) || slab.get(key) != val)
+                FAIL
+        }
+        for (uint64_t key : removed) {
+            if (slab.contains(key) || slab.remove(key))
+                FAIL
+        }
+        alive[thread_id] = own.size();
+    });
+
+    size_t total = 0;
+    for (size_t n : alive)
+        total += n;
+    if (slab.size() != total)
+        FAIL
+}
+
+/// Many threads removing the same keys, only one of them must succeed per key.
+void concurrent_remove() {
+    TEST
+
+    size_t n = 100000;
+    ConcurrentSlab<int> slab;
+    vector<uint64_t> keys;
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(slab.insert(int(i)));
+
+    vector<size_t> removed(4);
+    run_threads(4, [&](size_t thread_id) {
+        for (uint64_t key : keys)
+            removed[thread_id] += slab.remove(key);
+    });
+
+    if (removed[0] + removed[1] + removed[2] + removed[3] != n || !slab.empty())
+        FAIL
+}
+
+/// Each thread inserts to its own shard and removes objects of all shards.
+void sharded() {
+    TEST
+
+    size_t threads_num = 4;
+    size_t per_thread = 50000;
+    ShardedSlab<size_t> slab(threads_num);
+    vector<vector<uint64_t>> keys(threads_num);
+
+    run_threads(threads_num, [&](size_t thread_id) {
+        auto local = slab.local(thread_id);
+        for (size_t i = 0; i < per_thread; ++i) {
+            size_t val = thread_id << 32 | i;
+            uint64_t key = local.insert(val);
+            if (key >> 32 != thread_id || !local.contains(key) || local.get(key) != val)
+                FAIL
+            keys[thread_id].push_back(key);
+        }
+    });
+
+    // every thread removes the even keys of the next shard and the odd keys of its own one
+    run_threads(threads_num, [&](size_t thread_id) {
+        auto local = slab.local(thread_id);
+        auto &other = keys[(thread_id + 1) % threads_num];
+        for (size_t i = 0; i < per_thread; i += 2) {
+            if (local.contains(other[i]) || !local.remove(other[i]))
+                FAIL
+        }
+        for (size_t i = 1; i < per_thread; i += 2) {
+            if (!local.remove(keys[thread_id][i]) || local.remove(keys[thread_id][i]))
+                FAIL
+        }
+    });
+    if (slab.size() != threads_num * per_thread / 2)
+        FAIL
+
+    // remote frees are collected by the owners, freed slots are reused
+    run_threads(threads_num, [&](size_t thread_id) {
+        auto local = slab.local(thread_id);
+        if (local.collect() != per_thread / 2 || local.size() != 0)
+            FAIL
+
+        uint64_t key = local.emplace(size_t(42));
+        if ((uint32_t(key) & 0xffffff) >= per_thread || local.get(key) != 42)
+            FAIL
+    });
+    if (slab.size() != threads_num)
+        FAIL
+
+    // stale and repeated remote removes are dropped by the owner
+    {
+        ShardedSlab<string> stale(2);
+        auto owner = stale.local(0);
+        auto remote = stale.local(1);
+        uint64_t removed = owner.insert(string(100, 'a'));
+        remote.remove(removed);
+        remote.remove(removed);
+        remote.flush();
+        if (owner.collect() != 1)
+            FAIL
+        uint64_t reused = owner.insert(string(100, 'b'));
+        remote.remove(removed);
+        remote.flush();
+        if ((reused & 0xffffff) != (removed & 0xffffff) || owner.collect() != 0 || owner.get(reused) != string(100, 'b'))
+            FAIL
+    }
+
+    // uncollected remote frees are released with the slab
+    ShardedSlab<string> strings(2);
+    auto first = strings.local(0);
+    auto second = strings.local(1);
+    uint64_t key = first.insert(string(100, 'a'));
+    if (!second.remove(key) || first.take(key + 1) || second.take(key))
+        FAIL
+    second.flush();
+    if (strings.get(key) != string(100, 'a'))
+        FAIL
+
+    bool thrown = false;
+    try {
+        strings.local(2);
+    } catch (const out_of_range &) {
+        thrown = true;
+    }
+    if (!thrown)
+        FAIL
+}
+
+/// Insert/remove throughput of ConcurrentSlab and ShardedSlab against Slab with mutex.
+void bench_throughput() {
+    TEST
+
+    size_t ops = 2000000;
+    for (size_t threads_num : { 1, 2, 4, 8 }) {
+        auto churn = [&](auto &insert, auto &remove) {
+            auto start = steady_clock::now();
+            run_threads(threads_num, [&](size_t) {
+                vector<uint64_t> keys;
+                keys.reserve(64);
+                for (size_t i = 0; i < ops / threads_num / 64; ++i) {
+                    for (size_t j = 0; j < 64; ++j)
+                        keys.push_back(insert(int(j)));
+                    for (uint64_t key : keys)
+                        remove(key);
+                    keys.clear();
+                }
+            });
+            return duration_cast<milliseconds>(steady_clock::now() - start).count();
+        };
+
+        ConcurrentSlab<int> concurrent;
+        auto concurrent_insert = [&](int val) { return concurrent.insert(std::move(val)); };
+        auto concurrent_remove = [&](uint64_t key) { return concurrent.remove(key); };
+        auto concurrent_elapsed = churn(concurrent_insert, concurrent_remove);
+
+        // every thread removes a half of objects inserted by the other thread
+        ShardedSlab<int> sharded(threads_num);
+        auto sharded_elapsed = [&] {
+            auto start = steady_clock::now();
+            vector<vector<uint64_t>> published(threads_num);
+            run_threads(threads_num, [&](size_t thread_id) {
+                auto local = sharded.local(thread_id);
+                vector<uint64_t> keys;
+                keys.reserve(64);
+                for (size_t i = 0; i < ops / threads_num / 64; ++i) {
+                    for (size_t j = 0; j < 64; ++j)
+                        keys.push_back(local.insert(int(j)));
+                    for (size_t j = 0; j < 64; j += 2)
+                        local.remove(keys[j]);
+                    for (size_t j = 1; j < 64; j += 2)
+                        published[thread_id].push_back(keys[j]);
+                    keys.clear();
+                }
+            });
+            run_threads(threads_num, [&](size_t thread_id) {
+                auto local = sharded.local(thread_id);
+                for (uint64_t key : published[(thread_id + 1) % threads_num])
+                    local.remove(key);
+            });
+            return duration_cast<milliseconds>(steady_clock::now() - start).count();
+        }();
+
+        Slab<int> slab;
+        mutex mtx;
+        auto locked_insert = [&](int val) { lock_guard lock(mtx); return uint64_t(slab.insert(std::move(val))); };
+        auto locked_remove = [&](uint64_t key) { lock_guard lock(mtx); return slab.remove(key); };
+        auto locked_elapsed = churn(locked_insert, locked_remove);
+
+        cout << threads_num << " threads, " << ops * 2 << " operations: concurrent slab " << concurrent_elapsed
+             << " mills, sharded slab " << sharded_elapsed << " mills, slab with mutex " << locked_elapsed << " mills" << endl;
+    }
+}
+
+/// Run tests and returns 0 is successful. Return 1 if some test fail with macro FAIL was used.
+/// In fail case std::cout function name and line number of place where was used FAIL macro.
+int main() {
+    single_thread();
+    stress();
+    concurrent_remove();
+    sharded();
+//    bench_throughput();
+
+    cout << "All tests are successful." << std::endl;
+}
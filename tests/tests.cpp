@@ -6,10 +6,28 @@
 /// The function `main` at the end of the file.
 
 #include "../slab.h"
+#include "../mapped_slab.h"
+#include "../static_slab.h"
+#include "../multi_slab.h"
+#include "../slab_allocator.h"
+#include "../slab_map.h"
 #include <iostream>
 #include <chrono>
+#include <cstdio>
 #include <deque>
+#include <filesystem>
+#include <fstream>
 #include <initializer_list>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <sstream>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <string>
 #include <debug/debug.h>
 
 /// For easy debugging. By using FAIL macros will go to here
@@ -354,7 +372,7 @@ void capacity() {
     TEST
 
     Slab<int> slab;
-    if (slab.slots_capacity() != 0 || slab.stack_capacity() != 0)
+    if (slab.slots_capacity() != 0 || slab.memory_usage() != 0)
         FAIL;
 
     auto create_with_capacity = [&](size_t capacity) {
@@ -366,26 +384,31 @@ void capacity() {
             keys.push_back(key);
         }
 
-        if (slab.slots_capacity() != capacity || slab.stack_capacity() != capacity / 2)
+        if (slab.slots_capacity() != capacity)
             FAIL;
 
         size_t last_key = slab.insert(0);
-        if (slab.slots_capacity() <= capacity || slab.stack_capacity() != capacity / 2)
+        if (slab.slots_capacity() <= capacity)
             FAIL;
 
         size_t slots_capacity = slab.slots_capacity();
-        size_t stack_capacity = slab.stack_capacity();
+        size_t memory_usage = slab.memory_usage();
 
         for (int i = 0; i < keys.size() / 2; ++i) {
             slab.remove(keys[i]);
         }
 
-        if (slab.stack_capacity() != stack_capacity)
+        slab.remove(last_key);
+
+        // removing never allocates
+        if (slab.slots_capacity() != slots_capacity || slab.memory_usage() != memory_usage)
             FAIL;
 
-        slab.remove(last_key);
+        for (int i = 0; i < keys.size() / 2 + 1; ++i) {
+            slab.insert(0);
+        }
 
-        if (slab.stack_capacity() <= stack_capacity)
+        if (slab.slots_capacity() != slots_capacity)
             FAIL;
     };
 
@@ -533,92 +556,2079 @@ void iterators() {
          FAIL
 }
 
-void bench() {
+void sparse_iteration() {
     TEST
 
-    size_t n = 100000000;
+    Slab<int> slab;
+    for (int i = 0; i < 1000; ++i)
+        slab.insert(i);
 
-    // insert to allocated vec and slab
+    // leave a few elements with long vacant runs between them
+    vector<int> expected { 0, 63, 64, 127, 500, 999 };
+    for (int i = 0; i < 1000; ++i) {
+        if (find(expected.begin(), expected.end(), i) == expected.end())
+            slab.remove(i);
+    }
 
-    auto start = steady_clock::now();
-    Slab<int> slab(n);
-    for (int i = 0; i < n; ++i) {
-        slab.insert(std::move(i));
+    if (slab.size() != expected.size() || slab.contains(1) || slab.contains(998) || !slab.contains(500))
+        FAIL
+
+    if (!equal(slab.begin(), slab.end(), expected.begin(), expected.end()))
+        FAIL
+
+    vector<int> reversed;
+    auto it = slab.end();
+    do {
+        --it;
+        reversed.push_back(*it);
+    } while (it != slab.begin());
+    if (!equal(reversed.rbegin(), reversed.rend(), expected.begin(), expected.end()))
+        FAIL
+
+    slab.remove(0);
+    if (*slab.begin() != 63)
+        FAIL
+
+    slab.remove(999);
+    it = slab.end();
+    --it;
+    if (*it != 500)
+        FAIL
+
+    while (!slab.empty())
+        slab.remove(*slab.begin());
+    if (slab.begin() != slab.end())
+        FAIL
+
+    PagedSlab<int, 64> paged;
+    for (int i = 0; i < 300; ++i)
+        paged.insert(i);
+    for (int i = 0; i < 300; ++i) {
+        if (i % 100 != 0)
+            paged.remove(i);
     }
-    auto slab_elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
-    cout << "insert to alocated slab: " << slab_elapsed << " mills" << endl;
+    if (!equal(paged.begin(), paged.end(), vector { 0, 100, 200 }.begin()) || paged.contains(150))
+        FAIL
+}
 
-    start = steady_clock::now();
-    vector<int> vec(n);
-    for (int i = 0; i < n; ++i) {
-        vec[i] = i;
+void paged() {
+    TEST
+
+    PagedSlab<int, 4> slab;
+    if (slab.slots_capacity() != 0)
+        FAIL
+
+    size_t key0 = slab.insert(0);
+    int *ptr0 = &slab.get(key0);
+    if (slab.slots_capacity() != 4)
+        FAIL
+
+    vector<size_t> keys;
+    for (int i = 1; i < 100; ++i)
+        keys.push_back(slab.insert(i));
+
+    // growing doesn't relocate stored objects
+    if (&slab.get(key0) != ptr0 || *ptr0 != 0)
+        FAIL
+
+    if (slab.size() != 100 || slab.slots_capacity() != 100)
+        FAIL
+
+    vector<int> expected(100);
+    iota(expected.begin(), expected.end(), 0);
+    if (!equal(slab.begin(), slab.end(), expected.begin()))
+        FAIL
+
+    // remove the whole second page and one element from third
+    for (size_t key = 4; key < 9; ++key)
+        slab.remove(key);
+    expected.erase(expected.begin() + 4, expected.begin() + 9);
+    if (!equal(slab.begin(), slab.end(), expected.begin()) || slab.size() != 95)
+        FAIL
+
+    size_t i = 0;
+    for (auto it = slab.key_val_begin(); it != slab.key_val_end(); ++it, ++i) {
+        auto [key, val] = *it;
+        if (key != size_t(expected[i]) || val != expected[i])
+            FAIL
     }
-    auto vec_elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
-    cout << "insert to alocated vector: " << vec_elapsed << " mills" << endl;
 
-    // find element in middle
+    auto it = slab.end();
+    --it;
+    if (*it != 99)
+        FAIL
 
-    int find_val = n / 2 + n / 4;
+    if (slab.insert(8) != 8 || slab.get(8) != 8 || &slab.get(key0) != ptr0)
+        FAIL
 
-    start = steady_clock::now();
-    find_if(slab.begin(), slab.end(), [&](int x) { return x == find_val; });
-    auto slab_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "find element in middle slab: " << slab_elapsed_nanos << " nanos" << endl;
+    PagedSlab<int, 4> copy = slab;
+    if (!equal(copy.begin(), copy.end(), slab.begin()) || copy.size() != slab.size())
+        FAIL
 
-    start = steady_clock::now();
-    find_if(slab.begin(), slab.end(), [&](int x) { return x == find_val; });
-    auto vec_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "find element in middle vec: " << vec_elapsed_nanos << " nanos" << endl;
+    PagedSlab<string, 2> strings(3);
+    if (strings.slots_capacity() != 4)
+        FAIL
 
-    // remove each 2 element
+    size_t key = strings.insert(string(100, 'a'));
+    const string *str_ptr = &strings.get(key);
+    for (int i = 0; i < 10; ++i)
+        strings.insert(to_string(i));
+    if (&strings.get(key) != str_ptr || strings.get(key) != string(100, 'a'))
+        FAIL
+}
 
-    for (int i = 0; i < n; ++i) {
-        auto o = slab.get(i);
-        if (o && (o % 2) == 0) {
-            slab.remove(i);
+void generational() {
+    TEST
+
+    GenerationalSlab<int> slab;
+    size_t key0 = slab.insert(0);
+    size_t key1 = slab.insert(1);
+
+    if (slab.vacant_key() != slab.insert(2))
+        FAIL
+
+    if (!slab.contains(key0) || !slab.contains(key1) || slab.get(key1) != 1 || *slab.try_get(key1) != 1)
+        FAIL
+
+    if (!slab.remove(key1))
+        FAIL
+
+    // reused slot gets new key
+    size_t vacant = slab.vacant_key();
+    size_t key3 = slab.insert(3);
+    if (key3 == key1 || key3 != vacant || (key3 & 0xffffffff) != (key1 & 0xffffffff))
+        FAIL
+
+    // stale key is rejected
+    if (slab.contains(key1) || slab.try_get(key1) || slab.remove(key1) || slab.take(key1))
+        FAIL
+
+    if (!slab.contains(key3) || slab.get(key3) != 3 || slab.size() != 3)
+        FAIL
+
+    optional<int> val3 = slab.take(key3);
+    if (!val3 || *val3 != 3 || slab.take(key3) || slab.contains(key3))
+        FAIL
+
+    // key with the even generation of the vacant slot is rejected
+    size_t vacant_generation = (key3 & 0xffffffff) | (size_t(2) << 32);
+    if (slab.contains(vacant_generation) || slab.try_get(vacant_generation) || slab.remove(vacant_generation))
+        FAIL
+
+    slab.insert(4);
+    size_t i = 0;
+    for (auto it = slab.key_val_begin(); it != slab.key_val_end(); ++it, ++i) {
+        auto [key, val] = *it;
+        if (!slab.contains(key) || slab.get(key) != val)
+            FAIL
+    }
+    if (i != 3)
+        FAIL
+
+    // generation wraps around in narrow generation field
+    GenerationalSlab<int, 2> narrow;
+    size_t first = narrow.insert(0);
+    narrow.remove(first);
+    size_t second = narrow.insert(0);
+    if (second == first || narrow.contains(first))
+        FAIL
+    narrow.remove(second);
+    if (narrow.insert(0) != first || !narrow.contains(first))
+        FAIL
+}
+
+struct Traits16 : SlabTraits {
+    using key_type = uint16_t;
+};
+
+/// 24 bits of index and 8 bits of generation.
+struct Traits32 : SlabTraits {
+    using key_type = uint32_t;
+    static constexpr unsigned generation_bits = 8;
+};
+
+void key_types() {
+    TEST
+
+    Slab<int, Traits16> slab;
+    static_assert(is_same_v<decltype(slab.insert(0)), uint16_t>);
+    if (slab.max_size() != 0xffff)
+        FAIL
+
+    for (int i = 0; i < 0xffff; ++i) {
+        if (slab.insert(i) != uint16_t(i))
+            FAIL
+    }
+
+    // all keys are used
+    bool overflow = false;
+    try {
+        slab.insert(0);
+    } catch (const length_error &) {
+        overflow = true;
+    }
+    if (!overflow || slab.size() != 0xffff)
+        FAIL
+
+    // reusing removed keys is still possible
+    slab.remove(100);
+    if (slab.vacant_key() != 100 || slab.insert(-1) != 100 || slab.get(100) != -1)
+        FAIL
+
+    uint16_t sum_keys = 0;
+    for (auto it = slab.key_val_begin(); it != slab.key_val_end(); ++it)
+        sum_keys += (*it).first;
+    if (sum_keys != uint16_t(size_t(0xffff) * 0xfffe / 2))
+        FAIL
+
+    Slab<int, Traits32> gen_slab;
+    uint32_t key = gen_slab.insert(1);
+    gen_slab.remove(key);
+    uint32_t new_key = gen_slab.insert(2);
+    if (new_key == key || (new_key & 0xffffff) != 0 || gen_slab.contains(key) || gen_slab.get(new_key) != 2)
+        FAIL
+
+    if (gen_slab.max_size() != 0xffffff)
+        FAIL
+}
+
+/// Counts alive objects.
+struct Counted {
+    static int alive;
+    string str;
+
+    Counted(string str) : str(std::move(str)) { ++alive; }
+    Counted(const Counted &other) : str(other.str) { ++alive; }
+    Counted(Counted &&other) noexcept : str(std::move(other.str)) { ++alive; }
+    Counted& operator=(Counted &&other) noexcept { str = std::move(other.str); return *this; }
+    ~Counted() { --alive; }
+};
+
+int Counted::alive = 0;
+
+/// Returns runs of the slab as pairs of the first key and values.
+template <class Slab>
+auto collect_runs(Slab &slab) {
+    vector<pair<size_t, vector<uint64_t>>> runs;
+    slab.for_each_run([&](size_t first_key, auto run) {
+        runs.emplace_back(first_key, vector<uint64_t>(run.begin(), run.end()));
+        for (size_t i = 0; i < run.size(); ++i) {
+            if (&slab.get(run.key(i)) != &run[i])
+                runs.clear();
         }
+    });
+    return runs;
+}
+
+void runs() {
+    TEST
+
+    using Runs = vector<pair<size_t, vector<uint64_t>>>;
+
+    Slab<uint64_t> slab;
+    static_assert(Slab<uint64_t>::packed_runs && !Slab<int>::packed_runs && Slab<int, Traits16>::packed_runs);
+    static_assert(is_same_v<Slab<uint64_t>::Run::iterator, uint64_t*> && is_signed_v<Slab<uint64_t>::Iterator::difference_type>);
+    if (slab.runs().begin() != slab.runs().end() || !collect_runs(slab).empty())
+        FAIL
+
+    for (uint64_t i = 0; i < 200; ++i)
+        slab.insert(i * 10);
+    for (size_t key : { 0, 3, 4, 70, 199 })
+        slab.remove(key);
+    Runs runs = collect_runs(slab);
+    if (runs.size() != 3 || runs[0] != Runs::value_type { 1, { 10, 20 } } || runs[1].first != 5 || runs[1].second.size() != 65
+        || runs[2].first != 71 || runs[2].second.size() != 128 || runs[2].second.back() != 1980)
+        FAIL
+
+    // tight loop over the plain array of the run
+    uint64_t sum = 0;
+    for (auto run : slab.runs()) {
+        const uint64_t *data = run.data();
+        for (size_t i = 0; i < run.size(); ++i)
+            sum += data[i];
     }
+    if (sum != slab.sum())
+        FAIL
 
-    vec.erase(remove_if(vec.begin(), vec.end(), [&](int x) { return x % 2 == 0; }), vec.end());
+    // runs don't cross pages, objects in slots wider than them are reached with the strided iterator
+    PagedSlab<int, 64> paged;
+    for (int i = 0; i < 200; ++i)
+        paged.insert(i);
+    paged.remove(10);
+    vector<pair<size_t, size_t>> bounds;
+    paged.for_each_run([&](size_t first_key, PagedSlab<int, 64>::Run run) {
+        bounds.emplace_back(first_key, run.size());
+        if (run.end() - run.begin() != ptrdiff_t(run.size()) || *(run.begin() + 2) != int(first_key) + 2)
+            bounds.clear();
+    });
+    if (bounds != vector<pair<size_t, size_t>> { { 0, 10 }, { 11, 53 }, { 64, 64 }, { 128, 64 }, { 192, 8 } })
+        FAIL
+    auto run = *paged.runs().begin();
+    sort(run.begin(), run.end(), greater<int>());
+    if (paged.get(0) != 9 || paged.get(9) != 0)
+        FAIL
 
-    // remove element from middle
+    // keys of runs have generations
+    Slab<uint64_t, Traits32> generational;
+    vector<uint32_t> keys;
+    for (uint64_t i = 0; i < 10; ++i)
+        keys.push_back(generational.insert(i));
+    generational.remove(keys[2]);
+    uint32_t reused = generational.insert(2);
+    runs = collect_runs(generational);
+    if (runs.size() != 1 || runs[0].second.size() != 10 || runs[0].first != keys[0] || reused == keys[2])
+        FAIL
 
-    start = steady_clock::now();
-    slab.remove(n / 2);
-    slab_elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "remove element from middle slab: " << slab_elapsed << " nanos" << endl;
+    // iterator distance is signed
+    if (slab.begin() - slab.end() >= 0 || std::distance(slab.begin(), slab.end()) != ptrdiff_t(slab.size()))
+        FAIL
+}
 
-    start = steady_clock::now();
-    vec.erase(vec.begin() + vec.size() / 2);
-    vec_elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "remove element from middle vec: " << vec_elapsed << " nanos" << endl;
+void object_lifetime() {
+    TEST
+
+    {
+        Slab<Counted> slab;
+        vector<size_t> keys;
+        for (int i = 0; i < 100; ++i)
+            keys.push_back(slab.insert(Counted(string(30, 'a' + i % 26))));
+        if (Counted::alive != 100)
+            FAIL
 
-    if (slab_elapsed > vec_elapsed / 10000)
+        for (int i = 0; i < 100; i += 3)
+            slab.remove(keys[i]);
+        if (Counted::alive != 66)
+            FAIL
+
+        // inserting an object of the slab itself on growth
+        while (slab.size() < slab.slots_capacity())
+            slab.insert(Counted("x"));
+        size_t capacity = slab.slots_capacity();
+        size_t key = slab.insert(slab.get(keys[1]));
+        if (slab.slots_capacity() == capacity || slab.get(key).str != string(30, 'b') || slab.get(keys[1]).str != string(30, 'b'))
+            FAIL
+
+        Slab<Counted> copy = slab;
+        if (Counted::alive != int(slab.size() * 2))
+            FAIL
+
+        if (!equal(copy.begin(), copy.end(), slab.begin(), [](auto &a, auto &b) { return a.str == b.str; }))
+            FAIL
+
+        copy.remove(key);
+        if (copy.vacant_key() != key || slab.vacant_key() == key)
+            FAIL
+
+        Slab<Counted> moved = std::move(copy);
+        if (Counted::alive != int(slab.size() * 2 - 1) || !copy.empty() || moved.size() != slab.size() - 1)
+            FAIL
+
+        optional<Counted> taken = moved.take(keys[1]);
+        if (!taken || taken->str != string(30, 'b'))
+            FAIL
+
+        moved = slab;
+        if (Counted::alive != int(slab.size() * 2 + 1))
+            FAIL
+    }
+
+    if (Counted::alive != 0)
         FAIL
+}
 
-    // find last element
+/// Object that can't be copied or moved.
+struct NonMovable {
+    size_t key;
+    int val;
+    mutex mtx;
 
-    start = steady_clock::now();
-    find_if(slab.begin(), slab.end(), [&](int x) { return x == find_val; });
-    slab_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "find last in slab: " << slab_elapsed_nanos << " nanos" << endl;
+    NonMovable(int val) : key(0), val(val) {}
+    NonMovable(size_t key, int val) : key(key), val(val) {}
+    NonMovable(const NonMovable &) = delete;
+    NonMovable(NonMovable &&) = delete;
+};
 
-    start = steady_clock::now();
-    find_if(vec.begin(), vec.end(), [&](int x) { return x == find_val; });
-    vec_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "find last in vec: " << vec_elapsed_nanos << " nanos" << endl;
+void emplace() {
+    TEST
 
-    // insert one
+    {
+        Slab<TestStruct> slab;
+        int construct_cnt = 0; int copy_cnt = 0; int move_cnt = 0;
+        int assignment_cnt = 0; int assignment_move_cnt = 0;
+        slab.emplace(&construct_cnt, &copy_cnt, &move_cnt, &assignment_cnt, &assignment_move_cnt);
+        if (construct_cnt != 1 || copy_cnt != 0 || move_cnt != 0 || assignment_cnt != 0 || assignment_move_cnt != 0)
+            FAIL
+    }
 
-    start = steady_clock::now();
-    slab.insert(2);
-    slab_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "insert one to slab: " << slab_elapsed_nanos << " nanos" << endl;
+    Slab<string> strings;
+    size_t key0 = strings.emplace(3, 'a');
+    size_t key1 = strings.emplace("slab");
+    strings.remove(key0);
+    if (strings.emplace(2, 'b') != key0 || strings.get(key0) != "bb" || strings.get(key1) != "slab")
+        FAIL
 
-    start = steady_clock::now();
-    vec.push_back(2);
-    vec_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
-    cout << "insert one to vec: " << vec_elapsed_nanos << " nanos" << endl;
+    PagedSlab<NonMovable, 4> slab;
+    for (int i = 0; i < 10; ++i) {
+        size_t key = slab.emplace_with_key(i);
+        if (slab.get(key).key != key || slab.get(key).val != i)
+            FAIL
+    }
+
+    slab.remove(3);
+    slab.remove(7);
+    size_t key = slab.emplace_with_key(10);
+    if (key != 7 || slab.get(7).key != 7 || slab.get(7).val != 10)
+        FAIL
+
+    key = slab.emplace(11);
+    if (key != 3 || slab.get(3).key != 0 || slab.get(3).val != 11)
+        FAIL
+
+    // key passed to constructor is the key of the object in generational mode too
+    struct Keyed {
+        size_t key;
+        Keyed(size_t key) : key(key) {}
+    };
+    GenerationalSlab<Keyed> keyed;
+    size_t removed = keyed.emplace_with_key();
+    keyed.remove(removed);
+    key = keyed.emplace_with_key();
+    if (key == removed || keyed.get(key).key != key)
+        FAIL
+}
+
+void vacant_entries() {
+    TEST
+
+    struct Keyed {
+        size_t key;
+        string name;
+        Keyed(size_t key, string name) : key(key), name(std::move(name)) {}
+    };
+
+    Slab<Keyed> slab;
+    slab.emplace(0, "a");
+    slab.emplace(1, "b");
+    slab.emplace(2, "c");
+    slab.remove(1);
+
+    // the reserved slot isn't taken by objects inserted meanwhile
+    {
+        auto entry = slab.reserve();
+        if (entry.key() != 1 || slab.vacant_key() != 3 || slab.size() != 2 || slab.contains(1))
+            FAIL
+        size_t other = slab.emplace(3, "d");
+        Keyed &obj = entry.emplace(entry.key(), "e");
+        if (other != 3 || &obj != &slab.get(1) || obj.key != 1 || slab.size() != 4)
+            FAIL
+    }
+    if (slab.size() != 4 || slab.get(1).name != "e")
+        FAIL
+
+    // dropped entries return slots, the next insert takes them again
+    slab.remove(2);
+    {
+        auto first = slab.reserve();
+        auto second = slab.reserve();
+        if (first.key() != 2 || second.key() != 4 || slab.size() != 3)
+            FAIL
+        auto moved = std::move(second);
+    }
+    if (slab.vacant_key() != 2 || slab.size() != 3 || slab.slots_count() != 5)
+        FAIL
+    if (slab.emplace(2, "f") != 2 || slab.emplace(4, "g") != 4 || slab.emplace(5, "h") != 5)
+        FAIL
+    size_t count = 0;
+    for (Keyed &obj : slab) {
+        if (slab.get(obj.key).name != obj.name)
+            FAIL
+        ++count;
+    }
+    if (count != 6)
+        FAIL
+
+    // failed construction keeps the slot reserved until the entry is dropped
+    struct Throwing {
+        explicit Throwing(bool fail) {
+            if (fail)
+                throw runtime_error("construction failed");
+        }
+    };
+    Slab<Throwing> throwing;
+    throwing.emplace(false);
+    {
+        auto entry = throwing.reserve();
+        try {
+            entry.emplace(true);
+            FAIL
+        } catch (const runtime_error &) {
+        }
+        if (throwing.size() != 1 || throwing.vacant_key() != 2)
+            FAIL
+    }
+    if (throwing.vacant_key() != 1)
+        FAIL
+    throwing.reserve().emplace(false);
+    if (throwing.size() != 2 || throwing.vacant_key() != 2)
+        FAIL
+
+    // the reserved slot of the generational slab isn't an object until the entry is emplaced
+    {
+        GenerationalSlab<string> strings;
+        auto reserved = strings.reserve();
+        if (strings.contains(reserved.key()) || strings.take(reserved.key()) || strings.size() != 0)
+            FAIL
+        reserved.emplace("a");
+        if (!strings.contains(reserved.key()) || strings.get(reserved.key()) != "a")
+            FAIL
+    }
+
+    // keys of reserved slots have the next generation
+    GenerationalSlab<Keyed> keyed;
+    size_t removed = keyed.emplace(0, "");
+    keyed.remove(removed);
+    size_t vacant = keyed.vacant_key();
+    auto entry = keyed.reserve();
+    size_t key = entry.key();
+    if (key == removed || key != vacant || entry.emplace(key, "").key != key || !keyed.contains(key) || keyed.contains(removed))
+        FAIL
+}
+
+template <SlabReuse Reuse>
+struct ReuseTraits : SlabTraits {
+    static constexpr SlabReuse reuse = Reuse;
+};
+
+template <SlabReuse Reuse>
+struct PagedReuseTraits : ReuseTraits<Reuse> {
+    static constexpr size_t page_size = 64;
+    static constexpr unsigned generation_bits = 16;
+};
+
+/// Removes keys in the order and returns keys of following inserts.
+template <class Traits>
+vector<size_t> reuse_order(initializer_list<size_t> removed) {
+    Slab<int, Traits> slab;
+    for (int i = 0; i < 10; ++i)
+        slab.insert(i);
+    for (size_t key : removed)
+        slab.remove(key);
+    vector<size_t> keys;
+    for (size_t i = 0; i < removed.size() + 1; ++i) {
+        size_t vacant = slab.vacant_key();
+        size_t key = slab.emplace(0);
+        if (key != vacant)
+            return {};
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/// Checks that objects of the slab are the expected ones after random churn.
+template <class Traits>
+bool check_churn() {
+    Slab<size_t, Traits> slab;
+    map<size_t, size_t> expected;
+    uint64_t state = 42;
+    for (size_t i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        if (!expected.empty() && (state >> 33) % 3 == 0) {
+            auto it = expected.begin();
+            std::advance(it, (state >> 40) % expected.size());
+            if (slab.take(it->first) != it->second)
+                return false;
+            expected.erase(it);
+        } else if ((state >> 33) % 7 == 1) {
+            auto entry = slab.reserve();
+            size_t key = entry.key();
+            if ((state >> 40) % 2) {
+                expected[key] = entry.emplace(i);
+            } else {
+                size_t other = slab.insert(i);
+                if (other == key)
+                    return false;
+                expected[other] = i;
+            }
+        } else {
+            expected[slab.insert(i)] = i;
+        }
+    }
+    for (auto &[key, val] : expected) {
+        if (!slab.contains(key) || slab.get(key) != val)
+            return false;
+    }
+    return size_t(std::distance(slab.begin(), slab.end())) == expected.size() && slab.size() == expected.size();
+}
+
+void reuse_policies() {
+    TEST
+
+    // keys of following inserts after removing 7, 2 and 5, the last insert appends
+    if (reuse_order<SlabTraits>({ 7, 2, 5 }) != vector<size_t> { 5, 2, 7, 10 })
+        FAIL
+    if (reuse_order<ReuseTraits<SlabReuse::fifo>>({ 7, 2, 5 }) != vector<size_t> { 7, 2, 5, 10 })
+        FAIL
+    if (reuse_order<ReuseTraits<SlabReuse::lowest>>({ 7, 2, 5 }) != vector<size_t> { 2, 5, 7, 10 })
+        FAIL
+
+    if (!check_churn<SlabTraits>() || !check_churn<ReuseTraits<SlabReuse::fifo>>() || !check_churn<ReuseTraits<SlabReuse::lowest>>())
+        FAIL
+    if (!check_churn<PagedReuseTraits<SlabReuse::fifo>>() || !check_churn<PagedReuseTraits<SlabReuse::lowest>>())
+        FAIL
+
+    // lowest first packs objects at the front after churn
+    Slab<int, ReuseTraits<SlabReuse::lowest>> lowest;
+    Slab<int> lifo;
+    vector<size_t> lowest_keys, lifo_keys;
+    for (int i = 0; i < 1000; ++i) {
+        lowest_keys.push_back(lowest.insert(i));
+        lifo_keys.push_back(lifo.insert(i));
+    }
+    uint64_t state = 7;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        size_t pos = (state >> 33) % lowest_keys.size();
+        lowest.remove(lowest_keys[pos]);
+        lifo.remove(lifo_keys[pos]);
+        lowest_keys[pos] = lowest_keys.back();
+        lifo_keys[pos] = lifo_keys.back();
+        lowest_keys.pop_back();
+        lifo_keys.pop_back();
+        // the population shrinks and grows again
+        if (lowest_keys.size() < 500 || (state >> 40) % 2) {
+            lowest_keys.push_back(lowest.insert(i));
+            lifo_keys.push_back(lifo.insert(i));
+        }
+    }
+    size_t lowest_last = *max_element(lowest_keys.begin(), lowest_keys.end());
+    if (lowest_last + 1 != lowest.size() || *max_element(lifo_keys.begin(), lifo_keys.end()) <= lowest_last)
+        FAIL
+
+    // trim and compaction keep the lowest slot as the head
+    lowest.remove(3);
+    lowest.remove(1);
+    lowest.trim();
+    if (lowest.vacant_key() != 1 || lowest.insert(0) != 1 || lowest.insert(0) != 3)
+        FAIL
+    lowest.remove(2);
+    lowest.remove(0);
+    lowest.compact([](size_t, size_t) {});
+    if (lowest.vacant_key() != lowest.size() || lowest.insert(0) != lowest.size() - 1)
+        FAIL
+}
+
+/// Object which copy or move fails while the flag is set, except the first succeeding ones.
+/// The string is constructed over the slot before throwing.
+struct FailingCopy {
+    static inline bool fail = false;
+    static inline int succeeding = 0;
+    string text;
+
+    explicit FailingCopy(string text) : text(std::move(text)) {}
+    FailingCopy(const FailingCopy &other) : text(other.text) {
+        if (fail && succeeding-- == 0)
+            throw runtime_error("copy failed");
+    }
+    FailingCopy(FailingCopy &&other) : text(std::move(other.text)) {
+        if (fail && succeeding-- == 0)
+            throw runtime_error("move failed");
+    }
+};
+
+/// Runs the insert that must throw, the flag is reset even if it doesn't.
+template <class Insert>
+bool insert_fails(Insert &&insert) {
+    FailingCopy::fail = true;
+    bool thrown = false;
+    try {
+        insert();
+    } catch (const runtime_error &) {
+        thrown = true;
+    }
+    FailingCopy::fail = false;
+    FailingCopy::succeeding = 0;
+    return thrown;
+}
+
+void exception_safety() {
+    TEST
+
+    // failed construction in the vacant slot keeps the list of vacant slots
+    Slab<FailingCopy> slab;
+    for (int i = 0; i < 3; ++i)
+        slab.insert(FailingCopy(to_string(i)));
+    slab.remove(1);
+    if (!insert_fails([&] { slab.insert(FailingCopy("failed")); }))
+        FAIL
+    if (slab.size() != 2 || slab.vacant_key() != 1)
+        FAIL
+    if (slab.insert(FailingCopy("a")) != 1 || slab.insert(FailingCopy("b")) != 3 || slab.get(1).text != "a")
+        FAIL
+
+    // failed construction in the reserved slot keeps it skipped by the lowest first policy
+    Slab<FailingCopy, ReuseTraits<SlabReuse::lowest>> lowest;
+    for (int i = 0; i < 4; ++i)
+        lowest.insert(FailingCopy(to_string(i)));
+    lowest.remove(1);
+    auto entry = lowest.reserve();
+    lowest.remove(0);
+    FailingCopy source("failed");
+    if (entry.key() != 1 || !insert_fails([&] { entry.emplace(source); }))
+        FAIL
+    if (lowest.insert(FailingCopy("a")) != 0 || lowest.insert(FailingCopy("b")) != 4)
+        FAIL
+    entry.emplace(source);
+    if (lowest.size() != 5 || lowest.get(1).text != "failed" || lowest.vacant_key() != 5)
+        FAIL
+
+    // objects inserted by the range before the failed one stay in the slab
+    Slab<FailingCopy> ranged(8);
+    ranged.insert(FailingCopy("a"));
+    ranged.insert(FailingCopy("b"));
+    ranged.remove(0);
+    vector<FailingCopy> range(5, FailingCopy("c"));
+    vector<size_t> keys;
+    if (!insert_fails([&] { FailingCopy::succeeding = 3; ranged.insert_range(range.begin(), range.end(), back_inserter(keys)); }))
+        FAIL
+    if (keys != vector<size_t> { 0, 2, 3 } || ranged.size() != 4 || ranged.slots_count() != 4)
+        FAIL
+    size_t count = 0;
+    for (FailingCopy &obj : ranged)
+        count += obj.text == "c";
+    if (count != 3 || ranged.insert(FailingCopy("d")) != 4)
+        FAIL
+
+    // failed relocation keeps old objects, so the slab is unchanged
+    Slab<FailingCopy> relocated;
+    for (int i = 0; i < 4; ++i)
+        relocated.insert(FailingCopy(string(40, char('a' + i))));
+    if (!insert_fails([&] { FailingCopy::succeeding = 2; relocated.insert(FailingCopy(string(40, 'x'))); }))
+        FAIL
+    if (relocated.size() != 4 || relocated.vacant_key() != 4)
+        FAIL
+    count = 0;
+    for (FailingCopy &obj : relocated) {
+        if (obj.text != string(40, char('a' + count)))
+            FAIL
+        ++count;
+    }
+    if (count != 4 || relocated.insert(FailingCopy(string(40, 'e'))) != 4 || relocated.get(0).text != string(40, 'a'))
+        FAIL
+
+    // failed copy destroys copied objects, the source is unchanged
+    if (!insert_fails([&] { FailingCopy::succeeding = 2; Slab<FailingCopy> copy(relocated); }))
+        FAIL
+    if (relocated.size() != 5 || relocated.get(4).text != string(40, 'e'))
+        FAIL
+
+    // failed move to other resource leaves the new slab empty before its destructor
+    std::pmr::unsynchronized_pool_resource other_resource;
+    ::pmr::Slab<FailingCopy> moved_from(std::pmr::new_delete_resource());
+    for (int i = 0; i < 4; ++i)
+        moved_from.insert(FailingCopy(string(40, char('a' + i))));
+    moved_from.remove(1);
+    if (!insert_fails([&] { FailingCopy::succeeding = 1; ::pmr::Slab<FailingCopy> moved(std::move(moved_from), &other_resource); }))
+        FAIL
+    if (moved_from.size() != 3 || moved_from.get(3).text != string(40, 'd'))
+        FAIL
+}
+
+void bulk() {
+    TEST
+
+    Slab<int> slab;
+    vector<size_t> keys;
+    vector<int> vals { 0, 1, 2, 3, 4, 5, 6, 7 };
+    slab.insert_range(vals.begin(), vals.end(), back_inserter(keys));
+    if (keys != vector<size_t> { 0, 1, 2, 3, 4, 5, 6, 7 } || !equal(slab.begin(), slab.end(), vals.begin(), vals.end()))
+        FAIL
+
+    vector<size_t> to_remove { 1, 3, 5, 100, 3 };
+    if (slab.remove_keys(to_remove.begin(), to_remove.end()) != 3 || slab.size() != 5)
+        FAIL
+
+    // vacant slots are reused first, rest is appended
+    size_t new_keys[5];
+    vector<int> new_vals { 10, 11, 12, 13, 14 };
+    size_t *end = slab.insert_range(new_vals.begin(), new_vals.end(), new_keys);
+    if (end != new_keys + 5 || !equal(new_keys, end, vector<size_t> { 5, 3, 1, 8, 9 }.begin()))
+        FAIL
+
+    if (!equal(slab.begin(), slab.end(), vector { 0, 12, 2, 11, 4, 10, 6, 7, 13, 14 }.begin()) || slab.size() != 10)
+        FAIL
+
+    // input iterators
+    istringstream stream("20 21 22");
+    keys.clear();
+    slab.insert_range(istream_iterator<int>(stream), istream_iterator<int>(), back_inserter(keys));
+    if (keys != vector<size_t> { 10, 11, 12 } || slab.get(12) != 22)
+        FAIL
+
+    slab.remove_keys(keys.begin(), keys.end());
+    if (slab.size() != 10)
+        FAIL
+
+    // conversion from range elements
+    Slab<string> strings;
+    vector<const char*> chars { "a", "b" };
+    keys.clear();
+    strings.insert_range(chars.begin(), chars.end(), back_inserter(keys));
+    if (strings.get(keys[1]) != "b")
+        FAIL
+
+    GenerationalSlab<int> gen_slab;
+    vector<size_t> gen_keys(3);
+    gen_slab.insert_range(vals.begin(), vals.begin() + 3, gen_keys.begin());
+    gen_slab.remove_keys(gen_keys.begin(), gen_keys.end());
+    vector<size_t> reused_keys(3);
+    gen_slab.insert_range(vals.begin(), vals.begin() + 3, reused_keys.begin());
+    if (gen_slab.remove_keys(gen_keys.begin(), gen_keys.end()) != 0 || gen_slab.size() != 3)
+        FAIL
+    for (size_t key : reused_keys) {
+        if (!gen_slab.contains(key))
+            FAIL
+    }
+}
+
+/// Memory resource counting allocated bytes.
+class CountingResource : public std::pmr::memory_resource {
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        allocated -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    size_t allocated = 0;
+};
+
+/// Stateful allocator from the resource, propagates on move assignment but not on swap.
+template <class T>
+struct ResourceAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = true_type;
+    using propagate_on_container_swap = false_type;
+
+    std::pmr::memory_resource *resource;
+
+    explicit ResourceAllocator(std::pmr::memory_resource *resource) : resource(resource) {}
+    template <class U>
+    ResourceAllocator(const ResourceAllocator<U> &other) : resource(other.resource) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *p, size_t n) { resource->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    template <class U>
+    bool operator==(const ResourceAllocator<U> &other) const { return resource == other.resource; }
+    template <class U>
+    bool operator!=(const ResourceAllocator<U> &other) const { return resource != other.resource; }
+};
+
+void allocators() {
+    TEST
+
+    CountingResource resource;
+    {
+        ::pmr::Slab<string> slab(&resource);
+        if (slab.get_allocator().resource() != &resource)
+            FAIL
+
+        size_t key = slab.insert(string(100, 'a'));
+        for (int i = 0; i < 100; ++i)
+            slab.insert(to_string(i));
+        if (resource.allocated < slab.memory_usage() || slab.get(key) != string(100, 'a'))
+            FAIL
+
+        // copy takes the default resource, copy with allocator takes the specified one
+        ::pmr::Slab<string> copy(slab);
+        ::pmr::Slab<string> same_copy(slab, &resource);
+        if (copy.get_allocator().resource() != std::pmr::get_default_resource() || same_copy.get_allocator().resource() != &resource)
+            FAIL
+        if (!equal(copy.begin(), copy.end(), slab.begin(), slab.end()) || !equal(same_copy.begin(), same_copy.end(), slab.begin(), slab.end()))
+            FAIL
+
+        // move to other resource moves objects one by one and keeps own resource
+        size_t before = resource.allocated;
+        copy = std::move(same_copy);
+        if (copy.get_allocator().resource() != std::pmr::get_default_resource() || copy.get(key) != string(100, 'a') || copy.size() != 101)
+            FAIL
+        same_copy = ::pmr::Slab<string>(&resource);
+        if (resource.allocated >= before)
+            FAIL
+
+        // move with equal resource takes the memory
+        ::pmr::Slab<string> moved(std::move(slab), &resource);
+        if (moved.size() != 101 || !slab.empty() || moved.get(key) != string(100, 'a'))
+            FAIL
+    }
+    if (resource.allocated != 0)
+        FAIL
+
+    // pages, page directory and bitmap are allocated from the resource
+    {
+        ::pmr::Slab<int, PagedSlabTraits<16>> paged(100, &resource);
+        if (resource.allocated < 7 * 16 * sizeof(int))
+            FAIL
+        for (int i = 0; i < 1000; ++i)
+            paged.insert(i);
+        if (paged.get(999) != 999)
+            FAIL
+    }
+    if (resource.allocated != 0)
+        FAIL
+
+    // propagated allocator is moved with the memory, old memory is freed by the old allocator
+    CountingResource first, second;
+    {
+        Slab<string, SlabTraits, ResourceAllocator<string>> slab { ResourceAllocator<string>(&first) };
+        Slab<string, SlabTraits, ResourceAllocator<string>> other { ResourceAllocator<string>(&second) };
+        slab.insert(string(100, 'a'));
+        size_t key = other.insert(string(100, 'b'));
+        slab = std::move(other);
+        if (slab.get_allocator().resource != &second || slab.get(key) != string(100, 'b') || first.allocated != 0)
+            FAIL
+        slab.insert(string(100, 'c'));
+
+        Slab<int, PagedSlabTraits<16>, ResourceAllocator<int>> paged { ResourceAllocator<int>(&first) };
+        Slab<int, PagedSlabTraits<16>, ResourceAllocator<int>> other_paged { ResourceAllocator<int>(&second) };
+        for (int i = 0; i < 100; ++i) {
+            paged.insert(i);
+            other_paged.insert(-i);
+        }
+        paged = std::move(other_paged);
+        if (paged.get_allocator().resource != &second || paged.get(99) != -99 || first.allocated != 0)
+            FAIL
+    }
+    if (first.allocated != 0 || second.allocated != 0)
+        FAIL
+
+    // whole arena is freed at once
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), &resource);
+    ::pmr::Slab<int> in_arena(&arena);
+    for (int i = 0; i < 2000; ++i)
+        in_arena.insert(i);
+    if (resource.allocated == 0 || in_arena.get(1999) != 1999)
+        FAIL
+}
+
+/// Record stored in the mapped slab.
+struct Record {
+    uint64_t id;
+    double value;
+    char name[16];
+};
+
+void mapped() {
+    TEST
+
+    const char *path = "mapped_slab_test.bin";
+    std::remove(path);
+
+    vector<size_t> keys;
+    {
+        MappedSlab<Record> slab(path);
+        if (!slab.empty() || slab.slots_capacity() != 64)
+            FAIL
+
+        for (uint64_t i = 0; i < 1000; ++i)
+            keys.push_back(slab.emplace(Record { i, double(i) / 2, "record" }));
+        if (slab.size() != 1000 || slab.slots_capacity() != 1024 || slab.get(keys[999]).id != 999)
+            FAIL
+
+        // insert from the object of the slab itself during growth
+        MappedSlab<Record> small("mapped_slab_small.bin", 1);
+        size_t first = small.insert(Record { 7, 0, "" });
+        for (int i = 0; i < 100; ++i)
+            small.insert(small.get(first));
+        if (small.get(100).id != 7)
+            FAIL
+        std::remove("mapped_slab_small.bin");
+
+        for (size_t i = 0; i < 1000; i += 2)
+            slab.remove(keys[i]);
+        if (slab.remove(keys[0]) || slab.contains(keys[0]) || slab.try_get(keys[0]) || slab.take(keys[0]))
+            FAIL
+
+        optional<Record> taken = slab.take(keys[1]);
+        if (!taken || taken->id != 1 || slab.size() != 499)
+            FAIL
+        slab.sync();
+    }
+
+    {
+        // same key to object mapping and same list of vacant slots after reopening
+        MappedSlab<Record> slab(path);
+        if (slab.size() != 499 || slab.slots_capacity() != 1024)
+            FAIL
+        for (size_t i = 3; i < 1000; i += 2) {
+            if (!slab.contains(keys[i]) || slab.get(keys[i]).id != i || string(slab.get(keys[i]).name) != "record")
+                FAIL
+        }
+
+        // objects are enumerated with their keys without knowing them
+        size_t count = 0;
+        const MappedSlab<Record> &const_slab = slab;
+        for (auto it = const_slab.begin(); it != const_slab.end(); ++it, ++count) {
+            if (it.key() != keys[count * 2 + 3] || it->id != count * 2 + 3)
+                FAIL
+        }
+        if (count != 499)
+            FAIL
+        if (slab.insert(Record { 1, 0, "" }) != keys[1] || slab.insert(Record { 998, 0, "" }) != keys[998])
+            FAIL
+        slab.sync();
+    }
+
+    // file longer than the capacity in the header is rejected
+    size_t file_size = size_t(filesystem::file_size(path));
+    filesystem::resize_file(path, file_size + 4096);
+    bool thrown = false;
+    try {
+        MappedSlab<Record> slab(path);
+    } catch (const runtime_error &) {
+        thrown = true;
+    }
+    if (!thrown)
+        FAIL
+
+    {
+        // growing interrupted after extending the file: the pending capacity is in the header
+        // (64 byte aligned header with pending capacity at offset 40, 32 byte slots, then the bitmap)
+        if (file_size != 128 + 1024 * sizeof(Record) + 1024 / 8)
+            FAIL
+        filesystem::resize_file(path, 128 + 2048 * sizeof(Record) + 2048 / 8);
+        {
+            fstream file(path, ios::in | ios::out | ios::binary);
+            uint64_t pending = 2048;
+            file.seekp(40);
+            file.write(reinterpret_cast<const char*>(&pending), sizeof(pending));
+        }
+
+        // the tail is dropped and the file is opened with the old capacity
+        MappedSlab<Record> slab(path);
+        if (slab.size() != 501 || slab.slots_capacity() != 1024 || slab.get(keys[999]).id != 999)
+            FAIL
+        if (filesystem::file_size(path) != file_size)
+            FAIL
+        while (slab.slots_capacity() == 1024)
+            slab.insert(Record { 0, 0, "grown" });
+        if (slab.slots_capacity() != 2048 || slab.get(keys[3]).id != 3 || slab.size() != 1025)
+            FAIL
+        size_t grown = 0;
+        for (Record &record : slab)
+            grown += string(record.name) == "grown";
+        if (grown != 524)
+            FAIL
+    }
+
+    // file of other object type is rejected
+    thrown = false;
+    try {
+        MappedSlab<int> ints(path);
+    } catch (const runtime_error &) {
+        thrown = true;
+    }
+    if (!thrown)
+        FAIL
+
+    // file of the type with the same size but other tag is rejected
+    thrown = false;
+    try {
+        MappedSlab<Record> other(path, 64, 1);
+    } catch (const runtime_error &) {
+        thrown = true;
+    }
+    if (!thrown)
+        FAIL
+    std::remove(path);
+}
+
+void compaction() {
+    TEST
+
+    Slab<string> slab;
+    vector<size_t> keys;
+    for (int i = 0; i < 1000; ++i)
+        keys.push_back(slab.insert(to_string(i)));
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 10 != 3)
+            slab.remove(keys[i]);
+    }
+
+    // external references are patched by the callback
+    map<size_t, size_t> remap;
+    size_t moved = slab.compact([&](size_t old_key, size_t new_key) { remap[old_key] = new_key; });
+    if (moved != remap.size() || moved == 0 || slab.size() != 100 || slab.vacant_key() != 100)
+        FAIL
+    for (int i = 3; i < 1000; i += 10) {
+        auto it = remap.find(keys[i]);
+        size_t key = it == remap.end() ? keys[i] : it->second;
+        if (key >= 100 || slab.get(key) != to_string(i))
+            FAIL
+    }
+    if (distance(slab.begin(), slab.end()) != 100 || slab.insert("new") != 100)
+        FAIL
+
+    // compact slab stays as is
+    if (slab.compact([](size_t, size_t) { FAIL }) != 0)
+        FAIL
+
+    // with generations stale keys are rejected and lowest slots are reused first
+    GenerationalSlab<int> gen_slab;
+    vector<size_t> gen_keys;
+    for (int i = 0; i < 100; ++i)
+        gen_keys.push_back(gen_slab.insert(int(i)));
+    for (int i = 0; i < 90; ++i)
+        gen_slab.remove(gen_keys[i]);
+    gen_slab.compact([&](size_t old_key, size_t new_key) {
+        if (gen_slab.contains(old_key) || gen_slab.get(new_key) < 90)
+            FAIL
+    });
+    for (size_t key : gen_keys) {
+        if (gen_slab.contains(key))
+            FAIL
+    }
+    if (gen_slab.size() != 10 || gen_slab.insert(100) >> 32 == 0 || size_t(uint32_t(gen_slab.vacant_key())) != 11)
+        FAIL
+
+    // incremental compaction with inserts and removes between steps
+    Slab<int> inc;
+    vector<size_t> inc_keys;
+    for (int i = 0; i < 10000; ++i)
+        inc_keys.push_back(inc.insert(int(i)));
+    for (int i = 0; i < 10000; ++i) {
+        if (i % 7 != 0)
+            inc.remove(inc_keys[i]);
+    }
+
+    map<int, size_t> key_of;
+    for (auto it = inc.key_val_begin(); it != inc.key_val_end(); ++it)
+        key_of[(*it).second] = (*it).first;
+
+    auto update = [&](size_t old_key, size_t new_key) {
+        int val = inc.get(new_key);
+        if (key_of.at(val) != old_key)
+            FAIL
+        key_of[val] = new_key;
+    };
+
+    int steps = 0;
+    while (!inc.compact_step(16, update)) {
+        ++steps;
+        if (steps % 10 == 0) {
+            int val = 100000 + steps;
+            key_of[val] = inc.insert(int(val));
+            inc.remove(key_of.begin()->second);
+            key_of.erase(key_of.begin());
+        }
+    }
+    if (steps == 0 || inc.size() != key_of.size())
+        FAIL
+    for (auto [val, key] : key_of) {
+        if (key >= inc.size() || inc.get(key) != val)
+            FAIL
+    }
+}
+
+void trimming() {
+    TEST
+
+    Slab<string> slab;
+    vector<size_t> keys;
+    for (int i = 0; i < 1000; ++i)
+        keys.push_back(slab.insert(to_string(i)));
+    for (int i = 50; i < 1000; ++i) {
+        if (i != 500)
+            slab.remove(keys[i]);
+    }
+    slab.remove(keys[10]);
+    slab.remove(keys[20]);
+
+    // slots after the last object are dropped, lowest vacant slots are reused first
+    if (slab.trim() != 499 || slab.size() != 49 || slab.slots_capacity() != 1024 || slab.vacant_key() != 10)
+        FAIL
+    if (slab.get(keys[500]) != "500" || slab.contains(keys[600]) || slab.remove(keys[600]))
+        FAIL
+    if (slab.insert("a") != 10 || slab.insert("b") != 20 || slab.insert("c") != 50)
+        FAIL
+
+    if (slab.shrink_to_fit() != 0 || slab.slots_capacity() != 501 || slab.get(keys[500]) != "500" || slab.get(10) != "a")
+        FAIL
+
+    slab.remove(keys[500]);
+    if (slab.shrink_to_fit() != 450 || slab.slots_capacity() != 51 || slab.vacant_key() != 51)
+        FAIL
+
+    Slab<int> empty;
+    empty.insert(1);
+    empty.remove(0);
+    if (empty.shrink_to_fit() != 1 || empty.slots_capacity() != 0 || empty.insert(2) != 0)
+        FAIL
+
+    // stale keys of dropped slots stay rejected
+    GenerationalSlab<int> gen_slab;
+    vector<size_t> gen_keys;
+    for (int i = 0; i < 10; ++i)
+        gen_keys.push_back(gen_slab.insert(int(i)));
+    for (int round = 0; round < 3; ++round) {
+        for (size_t key : gen_keys)
+            gen_slab.remove(key);
+        if (gen_slab.trim() != 10)
+            FAIL
+        for (size_t i = 0; i < 10; ++i) {
+            size_t key = gen_slab.insert(int(i));
+            if (size_t(uint32_t(key)) != i)
+                FAIL
+            for (size_t old : gen_keys) {
+                if (old == key)
+                    FAIL
+            }
+            gen_keys[i] = key;
+        }
+    }
+
+    // empty pages are freed or released and then reused
+    PagedSlab<int, 1024> paged;
+    vector<size_t> paged_keys;
+    for (int i = 0; i < 10 * 1024; ++i)
+        paged_keys.push_back(paged.insert(int(i)));
+    for (int i = 2 * 1024; i < 10 * 1024; ++i) {
+        if (i < 6 * 1024 || i >= 7 * 1024 || i % 2)
+            paged.remove(paged_keys[i]);
+    }
+    if (paged.trim() != 3 * 1024 + 1 || paged.slots_capacity() != 7 * 1024 || paged.size() != 2 * 1024 + 512)
+        FAIL
+    for (int i = 0; i < 10 * 1024; ++i) {
+        bool alive = i < 2 * 1024 || (i >= 6 * 1024 && i < 7 * 1024 - 1 && i % 2 == 0);
+        if (paged.contains(paged_keys[i]) != alive || (alive && paged.get(paged_keys[i]) != i))
+            FAIL
+    }
+
+    // lowest slots first, through released pages
+    for (int i = 0; i < 4 * 1024; ++i) {
+        if (paged.insert(-i) != size_t(2 * 1024 + i))
+            FAIL
+    }
+    if (paged.insert(-1) != 6 * 1024 + 1 || paged.get(2 * 1024 + 5) != -5 || paged.size() != 6 * 1024 + 513)
+        FAIL
+}
+
+void parallel() {
+    TEST
+
+    Slab<size_t> slab;
+    size_t n = 100000;
+    for (size_t i = 0; i < n; ++i)
+        slab.insert(size_t(i));
+    // vacant runs longer than chunks
+    for (size_t i = 10000; i < 30000; ++i)
+        slab.remove(i);
+    for (size_t i = 0; i < n; i += 3)
+        slab.remove(i);
+
+    size_t expected = 0;
+    for (size_t val : slab)
+        expected += val;
+
+    for (size_t threads_num : { 0, 1, 3, 8 }) {
+        atomic<size_t> sum { 0 };
+        atomic<size_t> count { 0 };
+        slab.parallel_for_each([&](size_t &val) { sum += val; ++count; }, threads_num);
+        if (sum != expected || count != slab.size())
+            FAIL
+
+        // with keys
+        atomic<bool> keys_match { true };
+        slab.parallel_for_each([&](size_t key, size_t &val) {
+            if (key != val)
+                keys_match = false;
+            val *= 2;
+        }, threads_num);
+        if (!keys_match)
+            FAIL
+        slab.parallel_for_each([](size_t &val) { val /= 2; }, threads_num);
+
+        if (slab.parallel_reduce(size_t(0), plus<>(), [](size_t val) { return val; }, threads_num) != expected)
+            FAIL
+        size_t max_key = slab.parallel_reduce(size_t(0), [](size_t a, size_t b) { return max(a, b); },
+                                              [](size_t key, size_t) { return key; }, threads_num);
+        if (max_key != n - 2)
+            FAIL
+    }
+
+    // serial range of slots for external thread pools
+    size_t part = 0;
+    slab.for_each_in(10000, 40000, [&](size_t val) { part += val; });
+    size_t expected_part = 0;
+    for (size_t i = 30000; i < 40000; ++i) {
+        if (i % 3 != 0)
+            expected_part += i;
+    }
+    if (part != expected_part || slab.slots_count() != n)
+        FAIL
+
+    Slab<int> empty;
+    if (empty.parallel_reduce(7, plus<>(), [](int val) { return val; }) != 7)
+        FAIL
+
+    // exception is passed to the caller
+    bool thrown = false;
+    try {
+        slab.parallel_for_each([](size_t val) { if (val == 99998) throw runtime_error("stop"); }, 4);
+    } catch (const runtime_error &) {
+        thrown = true;
+    }
+    if (!thrown)
+        FAIL
+}
+
+/// Checks find(), count(), min(), max() and sum() against iteration over objects.
+template <class T, class Traits>
+void check_arithmetic(Slab<T, Traits> &slab, T needle) {
+    size_t expected_count = 0;
+    T expected_sum = T();
+    optional<T> expected_min, expected_max;
+    auto first = slab.end();
+    for (auto it = slab.begin(); it != slab.end(); ++it) {
+        T val = *it;
+        if (val == needle && expected_count++ == 0)
+            first = it;
+        expected_sum += val;
+        if (!expected_min || val < *expected_min)
+            expected_min = val;
+        if (!expected_max || *expected_max < val)
+            expected_max = val;
+    }
+
+    if (slab.count(needle) != expected_count || slab.find(needle) != first)
+        FAIL
+    if (slab.min() != expected_min || slab.max() != expected_max || slab.sum() != expected_sum)
+        FAIL
+}
+
+/// Fills the slab with full, partial and empty blocks of 64 slots and a partial tail and checks it.
+template <class T, class Traits>
+void check_arithmetic_layout() {
+    Slab<T, Traits> slab;
+    for (size_t i = 0; i < 5000; ++i)
+        slab.insert(T(i % 97) - T(i % 2 ? 40 : 0));
+    for (size_t i = 640; i < 1280; ++i)
+        slab.remove(typename Traits::key_type(i));
+    for (size_t i = 0; i < 5000; i += 7)
+        slab.remove(typename Traits::key_type(i));
+    check_arithmetic(slab, T(13));
+    check_arithmetic(slab, T(-1));
+    check_arithmetic(slab, T(1000));
+}
+
+void arithmetic() {
+    TEST
+
+    // values of 4 and 8 bytes in slots of 4, 8 and 16 bytes, pages shorter than a block
+    check_arithmetic_layout<int, SlabTraits>();
+    check_arithmetic_layout<int, Traits16>();
+    check_arithmetic_layout<float, Traits16>();
+    check_arithmetic_layout<uint64_t, SlabTraits>();
+    check_arithmetic_layout<int64_t, GenerationalSlabTraits<32>>();
+    check_arithmetic_layout<unsigned, Traits32>();
+    check_arithmetic_layout<double, PagedSlabTraits<256>>();
+    check_arithmetic_layout<short, PagedSlabTraits<16>>();
+
+    // the first matching object by key order, not by the position in the block
+    Slab<int> slab;
+    for (int i = 0; i < 200; ++i)
+        slab.insert(i % 3 == 0 ? 5 : 1000 + i);
+    slab.remove(0);
+    if (&*slab.find(5) != &slab.get(3) || slab.count(5) != 66)
+        FAIL
+
+    // unsigned extremes
+    Slab<uint32_t> extremes;
+    for (size_t i = 0; i < 100; ++i)
+        extremes.insert(uint32_t(i == 70 ? UINT32_MAX : i + 1));
+    if (extremes.max() != UINT32_MAX || extremes.min() != 1u)
+        FAIL
+
+    // empty slab
+    Slab<double> empty;
+    if (empty.min() || empty.max() || empty.sum() != 0.0 || empty.count(0.0) != 0 || empty.find(0.0) != empty.end())
+        FAIL
+
+    // not arithmetic objects are compared one by one
+    Slab<string> strings { "b", "a", "c", "a" };
+    if (strings.count("a") != 2 || strings.min() != "a" || strings.max() != "c" || strings.sum() != "bac" + string("a"))
+        FAIL
+}
+
+struct StatsTraits : SlabTraits {
+    static constexpr bool stats = true;
+};
+
+struct PagedStatsTraits : PagedSlabTraits<64> {
+    static constexpr bool stats = true;
+};
+
+void statistics() {
+    TEST
+
+    Slab<int, StatsTraits> slab;
+    vector<SlabGrowth> growths;
+    slab.set_growth_hook([&](const SlabGrowth &growth) { growths.push_back(growth); });
+
+    for (int i = 0; i < 100; ++i)
+        slab.insert(i);
+    SlabStats stats = slab.stats();
+    if (stats.inserts != 100 || stats.appended_slots != 100 || stats.reused_slots != 0 || stats.high_water_mark != 100)
+        FAIL
+    if (stats.reallocations == 0 || stats.reallocations != growths.size() || stats.bytes_moved == 0)
+        FAIL
+    size_t bytes_moved = 0;
+    for (const SlabGrowth &growth : growths) {
+        if (growth.new_capacity <= growth.old_capacity || growth.duration.count() < 0)
+            FAIL
+        bytes_moved += growth.bytes_moved;
+    }
+    if (bytes_moved != stats.bytes_moved || growths.back().new_capacity != slab.slots_capacity())
+        FAIL
+
+    // run of 20 vacant slots and 10 single ones
+    for (size_t key = 40; key < 60; ++key)
+        slab.remove(key);
+    for (size_t key = 0; key < 20; key += 2)
+        slab.remove(key);
+    for (int val : slab)
+        (void)val;
+    stats = slab.stats();
+    if (stats.removes != 30 || stats.fragmentation != 0.3 || stats.longest_vacant_run != 20)
+        FAIL
+
+    for (int i = 0; i < 10; ++i)
+        slab.insert(i);
+    vector<int> vals(50, 1);
+    vector<size_t> keys(50);
+    slab.insert_range(vals.begin(), vals.end(), keys.begin());
+    stats = slab.stats();
+    if (stats.inserts != 160 || stats.reused_slots != 30 || stats.appended_slots != 130 || stats.high_water_mark != 130)
+        FAIL
+
+    slab.reset_stats();
+    stats = slab.stats();
+    if (stats.inserts != 0 || stats.removes != 0 || stats.reallocations != 0 || stats.high_water_mark != slab.size())
+        FAIL
+
+    // paged storage grows without reallocations
+    Slab<int, PagedStatsTraits> paged;
+    size_t pages = 0;
+    paged.set_growth_hook([&](const SlabGrowth &growth) {
+        if (growth.bytes_moved != 0 || growth.new_capacity != growth.old_capacity + 64)
+            FAIL
+        ++pages;
+    });
+    for (int i = 0; i < 200; ++i)
+        paged.insert(i);
+    if (pages != 4 || paged.stats().reallocations != 0 || paged.stats().bytes_moved != 0)
+        FAIL
+
+    // disabled statistics take no space
+    if (sizeof(Slab<int>) >= sizeof(Slab<int, StatsTraits>))
+        FAIL
+}
+
+/// Fills the static slab in a constant expression.
+constexpr StaticSlab<int, 8> make_static_slab() {
+    StaticSlab<int, 8> slab { 10, 20, 30, 40 };
+    slab.remove(1);
+    slab.remove(3);
+    slab.insert(50); // reuses key 3
+    slab.take(0);
+    return slab;
+}
+
+void static_slab() {
+    TEST
+
+    // usable in constant expressions
+    constexpr StaticSlab<int, 8> slab = make_static_slab();
+    static_assert(slab.size() == 2 && slab.get(2) == 30 && slab.get(3) == 50 && !slab.contains(1));
+    static_assert(slab.vacant_key() == 0 && *slab.begin() == 30);
+    static_assert(sizeof(StaticSlab<uint32_t, 60>) <= 60 * sizeof(uint32_t) + 16);
+
+    StaticSlab<int, 64> ints;
+    for (int i = 0; i < 64; ++i) {
+        if (ints.vacant_key() != size_t(i) || ints.insert(i) != size_t(i))
+            FAIL
+    }
+    if (!ints.full() || ints.size() != 64)
+        FAIL
+
+    bool thrown = false;
+    try {
+        ints.insert(64);
+    } catch (const length_error &) {
+        thrown = true;
+    }
+    if (!thrown || ints.size() != 64)
+        FAIL
+
+    // vacant slots are reused from the last removed
+    ints.remove(10);
+    ints.remove(20);
+    if (ints.remove(20) || ints.try_get(20) || ints.vacant_key() != 20 || ints.insert(-1) != 20 || ints.insert(-2) != 10)
+        FAIL
+
+    for (int i = 0; i < 64; i += 2)
+        ints.remove(size_t(i));
+    int sum = 0;
+    for (auto it = ints.begin(); it != ints.end(); ++it) {
+        if (it.key() % 2 == 0 || *it != int(it.key()))
+            FAIL
+        sum += *it;
+    }
+    if (sum != 32 * 32 || ints.size() != 32)
+        FAIL
+
+    // reverse iteration and key value pairs
+    size_t expected = 63;
+    for (auto it = ints.end(); it != ints.begin(); expected -= 2) {
+        --it;
+        if (it.key() != expected || *it != int(expected))
+            FAIL
+    }
+    if (expected != size_t(-1))
+        FAIL
+    size_t visited = 0;
+    for (auto it = ints.key_val_begin(); it != ints.key_val_end(); ++it) {
+        auto [key, val] = *it;
+        if (key % 2 == 0 || val != int(key))
+            FAIL
+        val = -val;
+        ++visited;
+    }
+    const auto &const_ints = ints;
+    if (visited != 32 || (*const_ints.key_val_begin()).second != -1 || (*--const_ints.key_val_end()).first != 63)
+        FAIL
+    static_assert((*++slab.key_val_begin()).first == 3 && *--slab.end() == 50);
+
+    // objects with lifetime
+    {
+        StaticSlab<Counted, 16> counted;
+        for (int i = 0; i < 16; ++i)
+            counted.emplace(string(30, 'a' + i));
+        counted.remove(3);
+        optional<Counted> taken = counted.take(4);
+        if (Counted::alive != 15 || !taken || taken->str != string(30, 'e'))
+            FAIL
+
+        StaticSlab<Counted, 16> copy = counted;
+        if (Counted::alive != 15 + 14 || copy.vacant_key() != 4 || copy.get(5).str != string(30, 'f'))
+            FAIL
+
+        copy = std::move(counted);
+        counted.clear();
+        copy.insert(Counted("x"));
+        if (Counted::alive != 15 + 1 || copy.size() != 15 || !counted.empty())
+            FAIL
+    }
+    if (Counted::alive != 0)
+        FAIL
+    // failed construction in the vacant slot keeps the list of vacant slots
+    StaticSlab<FailingCopy, 8> failing;
+    for (int i = 0; i < 3; ++i)
+        failing.insert(FailingCopy(to_string(i)));
+    failing.remove(1);
+    if (!insert_fails([&] { failing.insert(FailingCopy("failed")); }))
+        FAIL
+    if (failing.size() != 2 || failing.vacant_key() != 1)
+        FAIL
+    if (failing.insert(FailingCopy("a")) != 1 || failing.insert(FailingCopy("b")) != 3 || failing.get(1).text != "a")
+        FAIL
+
+    // failed copy destroys copied objects, failed copy assignment leaves the slab empty
+    StaticSlab<FailingCopy, 8> source;
+    for (int i = 0; i < 4; ++i)
+        source.insert(FailingCopy(string(40, char('a' + i))));
+    if (!insert_fails([&] { FailingCopy::succeeding = 3; StaticSlab<FailingCopy, 8> copy(source); }))
+        FAIL
+    StaticSlab<FailingCopy, 8> assigned;
+    assigned.insert(FailingCopy(string(40, 'x')));
+    if (!insert_fails([&] { FailingCopy::succeeding = 3; assigned = source; }))
+        FAIL
+    if (!assigned.empty() || assigned.insert(FailingCopy("y")) != 0 || source.size() != 4)
+        FAIL
+}
+
+void multi_slab() {
+    TEST
+
+    struct Small {
+        uint8_t val;
+    };
+    struct Large {
+        uint64_t vals[8];
+        string name;
+    };
+
+    MultiSlab<Small, Large, Counted> slab;
+    using Multi = decltype(slab);
+
+    auto s0 = slab.insert(Small { 1 });
+    auto l0 = slab.emplace<Large>(Large { { 1, 2 }, "first" });
+    auto s1 = slab.insert(Small { 2 });
+    auto c0 = slab.emplace<Counted>("counted");
+    static_assert(is_same_v<decltype(s0), Multi::Key<Small>> && decltype(l0)::tag == 1);
+
+    // every type has its own pool and keys
+    if (s0.key != 0 || s1.key != 1 || l0.key != 0 || c0.key != 0)
+        FAIL
+    if (slab.size() != 4 || slab.size<Small>() != 2 || slab.get(s1).val != 2 || slab.get(l0).name != "first")
+        FAIL
+    if (slab.pool<Small>().memory_usage() >= slab.pool<Large>().memory_usage())
+        FAIL
+
+    // keys of different types in one collection
+    vector<Multi::AnyKey> keys = { s0, l0, s1, c0 };
+    size_t visited = 0;
+    for (Multi::AnyKey key : keys) {
+        if (!slab.visit(key, [&](auto &obj) { ++visited; (void)obj; }))
+            FAIL
+    }
+    if (visited != 4 || !slab.contains(keys[1]) || slab.contains(Multi::AnyKey { 7, 0 }))
+        FAIL
+
+    // const lvalues are copied, const slab is visited with const objects
+    const Large large { { 3 }, "copied" };
+    auto l1 = slab.insert(large);
+    const Multi &const_slab = slab;
+    string name;
+    if (!const_slab.visit(l1, [&](auto &obj) {
+            static_assert(is_const_v<remove_reference_t<decltype(obj)>>);
+            if constexpr (is_same_v<decay_t<decltype(obj)>, Large>)
+                name = obj.name;
+        }) || name != "copied" || large.name != "copied" || !slab.remove(l1))
+        FAIL
+
+    if (!slab.remove(keys[1]) || slab.remove(keys[1]) || slab.contains(l0) || slab.try_get(l0))
+        FAIL
+    optional<Counted> taken = slab.take(c0);
+    if (!taken || taken->str != "counted" || slab.contains(keys[3]) || slab.visit(keys[3], [](auto &) {}))
+        FAIL
+    taken.reset();
+
+    // visit_all walks pools type by type
+    for (int i = 0; i < 3; ++i)
+        slab.emplace<Counted>(to_string(i));
+    string order;
+    slab.visit_all([&](auto &obj) {
+        using T = decay_t<decltype(obj)>;
+        if constexpr (is_same_v<T, Small>)
+            order += char('0' + obj.val);
+        else if constexpr (is_same_v<T, Counted>)
+            order += obj.str;
+        else
+            order += "L";
+    });
+    if (order != "12012")
+        FAIL
+
+    // homogeneous pool with slab methods
+    int sum = 0;
+    slab.for_each<Small>([&](Small &obj) { sum += obj.val; });
+    auto &smalls = slab.pool<Small>();
+    if (sum != 3 || find_if(smalls.begin(), smalls.end(), [](const Small &obj) { return obj.val == 2; }) == smalls.end())
+        FAIL
+
+    {
+        MultiSlab<int, double> numbers;
+        for (int i = 0; i < 100; ++i) {
+            numbers.insert(i);
+            numbers.insert(i * 0.5);
+        }
+        if (numbers.pool<int>().sum() != 4950 || numbers.pool<double>().sum() != 2475.0 || numbers.empty())
+            FAIL
+    }
+
+    if (Counted::alive != 3)
+        FAIL
+}
+
+void slab_allocator() {
+    TEST
+
+    // deallocated blocks are reused first
+    SlabAllocator<uint64_t> alloc;
+    uint64_t *a = alloc.allocate(1);
+    uint64_t *b = alloc.allocate(1);
+    alloc.deallocate(a, 1);
+    if (alloc.allocate(1) != a || b != a + 1 || alloc.memory_usage() != 256 * sizeof(uint64_t))
+        FAIL
+
+    // rebinds share the arena, blocks of other sizes are from other pools
+    SlabAllocator<Record> records(alloc);
+    SlabAllocator<uint64_t> copy(records);
+    if (records != alloc || copy != alloc || SlabAllocator<uint64_t>() == alloc)
+        FAIL
+    Record *record = records.allocate(1);
+    copy.deallocate(b, 1);
+    if (alloc.allocate(1) != b || alloc.memory_usage() != 256 * (sizeof(uint64_t) + sizeof(Record)))
+        FAIL
+    records.deallocate(record, 1);
+    uint64_t *array = alloc.allocate(1000);
+    alloc.deallocate(array, 1000);
+
+    {
+        list<Counted, SlabAllocator<Counted>> counted;
+        for (int i = 0; i < 1000; ++i)
+            counted.emplace_back(to_string(i));
+        for (auto it = counted.begin(); it != counted.end();) {
+            it = stoi(it->str) % 3 ? counted.erase(it) : next(it);
+        }
+        size_t usage = counted.get_allocator().memory_usage();
+        for (int i = 0; i < 600; ++i)
+            counted.emplace_front(to_string(i));
+        if (counted.size() != 934 || Counted::alive != 934 || counted.get_allocator().memory_usage() != usage)
+            FAIL
+
+        // moved from containers stay usable
+        list<Counted, SlabAllocator<Counted>> moved = std::move(counted);
+        counted.emplace_back("x");
+        if (moved.size() != 934 || counted.size() != 1 || moved.get_allocator() != counted.get_allocator())
+            FAIL
+    }
+    if (Counted::alive != 0)
+        FAIL
+
+    map<int, string, less<int>, SlabAllocator<pair<const int, string>>> ordered;
+    unordered_map<int, int, hash<int>, equal_to<int>, SlabAllocator<pair<const int, int>>> hashed;
+    for (int i = 0; i < 5000; ++i) {
+        ordered.emplace(i, to_string(i));
+        hashed.emplace(i, i * 2);
+    }
+    for (int i = 0; i < 5000; i += 2) {
+        ordered.erase(i);
+        hashed.erase(i);
+    }
+    for (int i = 1; i < 5000; i += 2) {
+        if (ordered.at(i) != to_string(i) || hashed.at(i) != i * 2)
+            FAIL
+    }
+    auto ordered_copy = ordered;
+    if (ordered_copy != ordered || ordered_copy.get_allocator() != ordered.get_allocator())
+        FAIL
+}
+
+void slab_map() {
+    TEST
+
+    SlabMap<int> map;
+    vector<size_t> keys;
+    for (int i = 0; i < 10; ++i)
+        keys.push_back(map.insert(i * 10));
+    if (map.size() != 10 || !equal(map.begin(), map.end(), keys.begin(), keys.end(), [](int val, size_t key) { return val == int(key) * 10; }))
+        FAIL
+
+    // the last object takes the position of the removed one, keys stay the same
+    if (!map.remove(keys[2]) || map.remove(keys[2]) || map.contains(keys[2]) || map.try_get(keys[2]))
+        FAIL
+    if (map.data()[2] != 90 || map.keys()[2] != keys[9] || map.get(keys[9]) != 90 || map.index_of(keys[9]) != 2u)
+        FAIL
+    optional<int> taken = map.take(keys[0]);
+    if (!taken || *taken != 0 || map.size() != 8 || map.data()[0] != 80 || map.get(keys[8]) != 80)
+        FAIL
+    for (size_t i = 0; i < map.size(); ++i) {
+        if (map.get(map.keys()[i]) != map.data()[i])
+            FAIL
+    }
+
+    // keys of removed objects are reused, the object is appended
+    size_t key = map.emplace(100);
+    if (key != keys[0] || map.data()[map.size() - 1] != 100 || *map.try_get(key) != 100)
+        FAIL
+
+    int sum = 0;
+    for (int val : map)
+        sum += val;
+    if (sum != 10 + 30 + 40 + 50 + 60 + 70 + 80 + 90 + 100)
+        FAIL
+
+    // random operations against std::map
+    SlabMap<Counted, GenerationalSlabTraits<32>> counted;
+    std::map<size_t, string> expected;
+    uint64_t state = 3;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        if (!expected.empty() && (state >> 33) % 2) {
+            auto it = expected.begin();
+            std::advance(it, (state >> 40) % expected.size());
+            if (counted.get(it->first).str != it->second || !counted.remove(it->first))
+                FAIL
+            expected.erase(it);
+        } else {
+            expected[counted.emplace(to_string(i))] = to_string(i);
+        }
+    }
+    if (counted.size() != expected.size() || Counted::alive != int(expected.size()))
+        FAIL
+    for (auto &[key, str] : expected) {
+        if (!counted.contains(key) || counted.get(key).str != str)
+            FAIL
+    }
+
+    // stale keys stay rejected after clear
+    counted.clear();
+    if (!counted.empty() || Counted::alive != 0 || counted.contains(expected.begin()->first))
+        FAIL
+}
+
+void bench() {
+    TEST
+
+    size_t n = 100000000;
+
+    // insert to allocated vec and slab
+
+    auto start = steady_clock::now();
+    Slab<int> slab(n);
+    for (int i = 0; i < n; ++i) {
+        slab.insert(std::move(i));
+    }
+    auto slab_elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+    cout << "insert to alocated slab: " << slab_elapsed << " mills" << endl;
+    cout << "slab memory: " << slab.memory_usage() / (1024 * 1024) << " MiB" << endl;
+
+    start = steady_clock::now();
+    vector<int> vec(n);
+    for (int i = 0; i < n; ++i) {
+        vec[i] = i;
+    }
+    auto vec_elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+    cout << "insert to alocated vector: " << vec_elapsed << " mills" << endl;
+
+    // find element in middle
+
+    int find_val = n / 2 + n / 4;
+
+    start = steady_clock::now();
+    find_if(slab.begin(), slab.end(), [&](int x) { return x == find_val; });
+    auto slab_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "find element in middle slab: " << slab_elapsed_nanos << " nanos" << endl;
+
+    start = steady_clock::now();
+    find_if(vec.begin(), vec.end(), [&](int x) { return x == find_val; });
+    auto vec_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "find element in middle vec: " << vec_elapsed_nanos << " nanos" << endl;
+
+    // remove each 2 element
+
+    for (int i = 0; i < n; ++i) {
+        auto o = slab.get(i);
+        if (o && (o % 2) == 0) {
+            slab.remove(i);
+        }
+    }
+
+    vec.erase(remove_if(vec.begin(), vec.end(), [&](int x) { return x % 2 == 0; }), vec.end());
+
+    // remove element from middle
+
+    start = steady_clock::now();
+    slab.remove(n / 2);
+    slab_elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "remove element from middle slab: " << slab_elapsed << " nanos" << endl;
+
+    start = steady_clock::now();
+    vec.erase(vec.begin() + vec.size() / 2);
+    vec_elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "remove element from middle vec: " << vec_elapsed << " nanos" << endl;
+
+    // find last element
+
+    start = steady_clock::now();
+    find_if(slab.begin(), slab.end(), [&](int x) { return x == find_val; });
+    slab_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "find last in slab: " << slab_elapsed_nanos << " nanos" << endl;
+
+    start = steady_clock::now();
+    find_if(vec.begin(), vec.end(), [&](int x) { return x == find_val; });
+    vec_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "find last in vec: " << vec_elapsed_nanos << " nanos" << endl;
+
+    start = steady_clock::now();
+    slab.find(find_val);
+    slab_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "find last in slab with slab.find: " << slab_elapsed_nanos << " nanos" << endl;
+
+    // insert one
+
+    start = steady_clock::now();
+    slab.insert(2);
+    slab_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "insert one to slab: " << slab_elapsed_nanos << " nanos" << endl;
+
+    start = steady_clock::now();
+    vec.push_back(2);
+    vec_elapsed_nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "insert one to vec: " << vec_elapsed_nanos << " nanos" << endl;
+}
+
+/// Slab made with two std::vectors, where the first one is element slots
+/// and the second is the stack of removed elements slots keys.
+/// The previous design of the slab, used as the reference in benchmarks.
+template <class T>
+struct TwoVectorSlab {
+    vector<optional<T>> slots_pool;
+    vector<size_t> stack_of_removed;
+
+    size_t insert(T &&obj) {
+        if (stack_of_removed.empty()) {
+            slots_pool.emplace_back(std::move(obj));
+            return slots_pool.size() - 1;
+        }
+        size_t key = stack_of_removed.back();
+        slots_pool[key].emplace(std::move(obj));
+        stack_of_removed.pop_back();
+        return key;
+    }
+
+    bool remove(size_t key) {
+        if (key >= slots_pool.size() || slots_pool[key] == std::nullopt)
+            return false;
+        slots_pool[key] = std::nullopt;
+        stack_of_removed.push_back(key);
+        return true;
+    }
+
+    size_t memory_usage() const {
+        return slots_pool.capacity() * sizeof(optional<T>) + stack_of_removed.capacity() * sizeof(size_t);
+    }
+};
+
+/// Element of 64 bytes for benchmarks.
+struct Payload64 {
+    int x;
+    char data[60];
+
+    Payload64(int x) : x(x) {}
+};
+
+/// Insert/remove churn: fills the slab, then repeatedly removes
+/// a half of elements in random order and inserts them back.
+template <class S, class T>
+void churn(size_t n, size_t rounds, const char *name) {
+    S slab;
+    vector<size_t> keys;
+    keys.reserve(n);
+
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(slab.insert(T(int(i))));
+
+    uint64_t rnd = 88172645463325252ull;
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < n / 2; ++i) {
+            rnd ^= rnd << 13; rnd ^= rnd >> 7; rnd ^= rnd << 17;
+            swap(keys[i], keys[i + rnd % (n - i)]);
+            slab.remove(keys[i]);
+        }
+        for (size_t i = 0; i < n / 2; ++i)
+            keys[i] = slab.insert(T(int(i)));
+    }
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+    // measure with half removed elements
+    for (size_t i = 0; i < n / 2; ++i)
+        slab.remove(keys[i]);
+
+    cout << name << ", " << n << " elements of " << sizeof(T) << " bytes: churn " << elapsed
+         << " mills, memory with half removed " << slab.memory_usage() / 1024 << " KiB" << endl;
+}
+
+void bench_free_list() {
+    TEST
+
+    for (size_t n : { 100000, 10000000 }) {
+        size_t rounds = 20000000 / n;
+        churn<TwoVectorSlab<int>, int>(n, rounds, "two vectors");
+        churn<Slab<int>, int>(n, rounds, "intrusive free list");
+        churn<TwoVectorSlab<Payload64>, Payload64>(n, rounds / 4, "two vectors");
+        churn<Slab<Payload64>, Payload64>(n, rounds / 4, "intrusive free list");
+    }
+}
+
+void bench_bulk() {
+    TEST
+
+    size_t n = 10000000;
+    vector<int> vals(n);
+    iota(vals.begin(), vals.end(), 0);
+    vector<size_t> keys(n);
+
+    // insert to empty slab, remove all, insert again to vacant slots
+    for (int pass = 0; pass < 2; ++pass) {
+        Slab<int> slab;
+        long long elapsed[3];
+        for (int stage = 0; stage < 3; ++stage) {
+            auto start = steady_clock::now();
+            if (stage == 1) {
+                if (pass == 0) {
+                    for (size_t i = 0; i < n; ++i)
+                        slab.remove(keys[i]);
+                } else {
+                    slab.remove_keys(keys.begin(), keys.end());
+                }
+            } else {
+                if (pass == 0) {
+                    for (size_t i = 0; i < n; ++i)
+                        keys[i] = slab.insert(vals[i]);
+                } else {
+                    slab.insert_range(vals.begin(), vals.end(), keys.begin());
+                }
+            }
+            elapsed[stage] = duration_cast<milliseconds>(steady_clock::now() - start).count();
+        }
+
+        cout << (pass == 0 ? "single element loop" : "bulk") << ": insert " << elapsed[0] << " mills, remove "
+             << elapsed[1] << " mills, insert to vacant " << elapsed[2] << " mills" << endl;
+    }
+}
+
+/// Restart: rebuilding the slab by inserting records against reopening the mapped slab.
+void bench_mapped() {
+    TEST
+
+    const char *path = "mapped_slab_bench.bin";
+    std::remove(path);
+    size_t n = 5000000;
+    {
+        MappedSlab<Record> slab(path, n);
+        for (uint64_t i = 0; i < n; ++i)
+            slab.insert(Record { i, 0, "" });
+        slab.sync();
+    }
+
+    auto start = steady_clock::now();
+    Slab<Record> rebuilt;
+    for (uint64_t i = 0; i < n; ++i)
+        rebuilt.insert(Record { i, 0, "" });
+    auto rebuild_elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    MappedSlab<Record> reopened(path);
+    auto reopen_elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+    if (reopened.size() != n || reopened.get(n - 1).id != n - 1)
+        FAIL
+
+    cout << n << " records: rebuild by insert " << rebuild_elapsed << " micros, reopen mapped file "
+         << reopen_elapsed << " micros" << endl;
+    std::remove(path);
 }
 
 /// Run tests and returns 0 is successful. Return 1 if some test fail with macro FAIL was used.
@@ -633,7 +2643,32 @@ int main() {
     capacity();
     initializer_lists();
     iterators();
+    sparse_iteration();
+    paged();
+    generational();
+    key_types();
+    runs();
+    object_lifetime();
+    emplace();
+    vacant_entries();
+    reuse_policies();
+    exception_safety();
+    bulk();
+    allocators();
+    mapped();
+    compaction();
+    trimming();
+    parallel();
+    arithmetic();
+    statistics();
+    static_slab();
+    multi_slab();
+    slab_allocator();
+    slab_map();
 //    bench();
+//    bench_free_list();
+//    bench_bulk();
+//    bench_mapped();
 
     cout << "All tests are successful." << std::endl;
 }